@@ -0,0 +1,879 @@
+/**
+ * @brief Built-in AgentX subagent engine implementation.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "config.h"
+#include "tracing.hpp"
+#include "agentx.hpp"
+#include "loop.hpp"
+
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+// RFC 2741, 6.1 AgentX PDU header
+static constexpr size_t HEADER_SIZE = 20;
+static constexpr uint8_t VERSION = 1;
+static constexpr size_t MAX_PAYLOAD = 1 << 20;
+// Stop adding GetBulk repetitions past this response size.
+static constexpr size_t MAX_RESPONSE = 1 << 16;
+
+enum PduType : uint8_t
+{
+    OPEN = 1,
+    CLOSE = 2,
+    REGISTER = 3,
+    GET = 5,
+    GETNEXT = 6,
+    GETBULK = 7,
+    TESTSET = 8,
+    COMMITSET = 9,
+    UNDOSET = 10,
+    CLEANUPSET = 11,
+    RESPONSE = 18,
+};
+
+enum Flags : uint8_t
+{
+    NON_DEFAULT_CONTEXT = 0x08,
+    NETWORK_BYTE_ORDER = 0x10,
+};
+
+enum VarbindType : uint16_t
+{
+    NO_SUCH_OBJECT = 128,
+    NO_SUCH_INSTANCE = 129,
+    END_OF_MIB_VIEW = 130,
+};
+
+enum Error : uint16_t
+{
+    NO_ERROR = 0,
+    NOT_WRITABLE = 17,
+};
+
+// Close reason
+static constexpr uint8_t REASON_SHUTDOWN = 5;
+
+// Prefix of the compressed OIDs: 1.3.6.1.<prefix>
+static constexpr oid INTERNET[] = {1, 3, 6, 1};
+
+/**
+ * @brief Reader of the PDU fields in the receive buffer.
+ */
+class AgentX::Reader
+{
+  public:
+    Reader(const uint8_t* data, size_t size) : _data(data), _size(size)
+    {
+    }
+
+    /** @brief Read and check the header, set the byte order. */
+    bool header()
+    {
+        if (_size < HEADER_SIZE || _data[0] != VERSION)
+        {
+            return false;
+        }
+        type = _data[1];
+        flags = _data[2];
+        _bigEndian = flags & NETWORK_BYTE_ORDER;
+        _offset = 4;
+        return u32(sessionId) && u32(transactionId) && u32(packetId) &&
+               u32(payload);
+    }
+
+    bool u8(uint8_t& value)
+    {
+        if (!available(1))
+        {
+            return false;
+        }
+        value = _data[_offset++];
+        return true;
+    }
+
+    bool u16(uint16_t& value)
+    {
+        uint64_t v;
+        if (!integer(v, 2))
+        {
+            return false;
+        }
+        value = static_cast<uint16_t>(v);
+        return true;
+    }
+
+    bool u32(uint32_t& value)
+    {
+        uint64_t v;
+        if (!integer(v, 4))
+        {
+            return false;
+        }
+        value = static_cast<uint32_t>(v);
+        return true;
+    }
+
+    /** @brief Read OID, RFC 2741 5.1. */
+    bool objectId(OidBuffer& buffer, bool* include = nullptr)
+    {
+        if (!available(4))
+        {
+            return false;
+        }
+        size_t count = _data[_offset];
+        uint8_t prefix = _data[_offset + 1];
+        if (include)
+        {
+            *include = _data[_offset + 2] != 0;
+        }
+        _offset += 4;
+
+        buffer.length = 0;
+        if (prefix)
+        {
+            std::copy(std::begin(INTERNET), std::end(INTERNET),
+                      buffer.arcs.begin());
+            buffer.arcs[4] = prefix;
+            buffer.length = 5;
+        }
+        if (buffer.length + count > buffer.arcs.size() ||
+            !available(count * 4))
+        {
+            return false;
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint32_t arc;
+            u32(arc);
+            buffer.arcs[buffer.length++] = arc;
+        }
+        return true;
+    }
+
+    /** @brief Skip octet string, RFC 2741 5.3. */
+    bool skipOctets()
+    {
+        uint32_t length;
+        if (!u32(length))
+        {
+            return false;
+        }
+        size_t padded = (static_cast<size_t>(length) + 3) & ~size_t(3);
+        if (!available(padded))
+        {
+            return false;
+        }
+        _offset += padded;
+        return true;
+    }
+
+    /** @brief Check if the whole payload is read. */
+    bool done() const
+    {
+        return _offset >= _size;
+    }
+
+    uint8_t type = 0;
+    uint8_t flags = 0;
+    uint32_t sessionId = 0;
+    uint32_t transactionId = 0;
+    uint32_t packetId = 0;
+    uint32_t payload = 0;
+
+  private:
+    bool available(size_t count) const
+    {
+        return _offset + count <= _size;
+    }
+
+    bool integer(uint64_t& value, size_t bytes)
+    {
+        if (!available(bytes))
+        {
+            return false;
+        }
+        value = 0;
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            size_t shift = _bigEndian ? (bytes - 1 - i) * 8 : i * 8;
+            value |= uint64_t(_data[_offset + i]) << shift;
+        }
+        _offset += bytes;
+        return true;
+    }
+
+    const uint8_t* _data;
+    size_t _size;
+    size_t _offset = 0;
+    bool _bigEndian = false;
+};
+
+/**
+ * @brief Writer of the PDU in network byte order into the send buffer.
+ */
+class AgentX::Writer
+{
+  public:
+    Writer(std::vector<uint8_t>& buffer, uint8_t type, uint32_t sessionId,
+           uint32_t transactionId, uint32_t packetId) :
+        _buffer(buffer),
+        _start(buffer.size())
+    {
+        u8(VERSION);
+        u8(type);
+        u8(NETWORK_BYTE_ORDER);
+        u8(0);
+        u32(sessionId);
+        u32(transactionId);
+        u32(packetId);
+        u32(0); // Payload length, set by `finish()`
+    }
+
+    void u8(uint8_t value)
+    {
+        _buffer.push_back(value);
+    }
+
+    void u16(uint16_t value)
+    {
+        integer(value, 2);
+    }
+
+    void u32(uint32_t value)
+    {
+        integer(value, 4);
+    }
+
+    void u64(uint64_t value)
+    {
+        integer(value, 8);
+    }
+
+    /** @brief Write OID, compressing 1.3.6.1.X prefix. */
+    void objectId(const oid* name, size_t length, bool include = false)
+    {
+        uint8_t prefix = 0;
+        if (length > 4 && name[4] > 0 && name[4] <= UINT8_MAX &&
+            std::equal(std::begin(INTERNET), std::end(INTERNET), name))
+        {
+            prefix = static_cast<uint8_t>(name[4]);
+            name += 5;
+            length -= 5;
+        }
+        u8(static_cast<uint8_t>(length));
+        u8(prefix);
+        u8(include ? 1 : 0);
+        u8(0);
+        for (size_t i = 0; i < length; ++i)
+        {
+            u32(static_cast<uint32_t>(name[i]));
+        }
+    }
+
+    void octets(const void* data, size_t length)
+    {
+        u32(static_cast<uint32_t>(length));
+        auto bytes = static_cast<const uint8_t*>(data);
+        _buffer.insert(_buffer.end(), bytes, bytes + length);
+        _buffer.resize(_buffer.size() + ((4 - length % 4) % 4), 0);
+    }
+
+    /** @brief Write varbind with exception value. */
+    void exception(const oid* name, size_t length, uint16_t type)
+    {
+        u16(type);
+        u16(0);
+        objectId(name, length);
+    }
+
+    /** @brief Write varbind of the net-snmp variable. */
+    void varbind(const netsnmp_variable_list* var)
+    {
+        u16(var->type);
+        u16(0);
+        objectId(var->name, var->name_length);
+
+        switch (var->type)
+        {
+            case ASN_INTEGER:
+            case ASN_COUNTER:
+            case ASN_GAUGE:
+            case ASN_TIMETICKS:
+                u32(static_cast<uint32_t>(*var->val.integer));
+                break;
+
+            case ASN_COUNTER64:
+                u64((uint64_t(var->val.counter64->high) << 32) |
+                    (var->val.counter64->low & 0xffffffff));
+                break;
+
+            case ASN_OCTET_STR:
+            case ASN_IPADDRESS:
+            case ASN_OPAQUE:
+                octets(var->val.string, var->val_len);
+                break;
+
+            case ASN_OBJECT_ID:
+                objectId(var->val.objid, var->val_len / sizeof(oid));
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    /** @brief Current size of the PDU. */
+    size_t size() const
+    {
+        return _buffer.size() - _start;
+    }
+
+    /** @brief Set the payload length. */
+    void finish()
+    {
+        uint32_t payload = static_cast<uint32_t>(size() - HEADER_SIZE);
+        for (size_t i = 0; i < 4; ++i)
+        {
+            _buffer[_start + 16 + i] =
+                static_cast<uint8_t>(payload >> ((3 - i) * 8));
+        }
+    }
+
+  private:
+    void integer(uint64_t value, size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i)
+        {
+            _buffer.push_back(
+                static_cast<uint8_t>(value >> ((bytes - 1 - i) * 8)));
+        }
+    }
+
+    std::vector<uint8_t>& _buffer;
+    size_t _start;
+};
+
+AgentX& AgentX::instance()
+{
+    static AgentX engine;
+    return engine;
+}
+
+void AgentX::init(const sdeventplus::Event& event)
+{
+    if (!enabled)
+    {
+        return;
+    }
+
+    _event.emplace(event);
+    _reconnect =
+        std::make_unique<Reconnect>("AgentX engine", [this]() { connect(); });
+    connect();
+}
+
+void AgentX::destroy()
+{
+    if (State::Open == _state)
+    {
+        Writer writer(_tx, CLOSE, _sessionId, 0, ++_packetId);
+        writer.u8(REASON_SHUTDOWN);
+        writer.u8(0);
+        writer.u8(0);
+        writer.u8(0);
+        send(writer);
+    }
+
+    // No reconnection on shutdown.
+    _reconnect.reset();
+    _event.reset();
+    disconnect();
+    _io.reset();
+
+    DEBUGMSGTL(("agentx:engine",
+                "requests=%llu, varbinds=%llu, sessions=%llu\n",
+                static_cast<unsigned long long>(_requests),
+                static_cast<unsigned long long>(_varbinds),
+                static_cast<unsigned long long>(_sessions)));
+}
+
+void AgentX::add(Subtree* subtree)
+{
+    auto it = std::upper_bound(
+        _subtrees.begin(), _subtrees.end(), subtree,
+        [](const Subtree* a, const Subtree* b) {
+            return snmp_oid_compare(a->root().data(), a->root().size(),
+                                    b->root().data(), b->root().size()) < 0;
+        });
+    _subtrees.insert(it, subtree);
+
+    if (State::Open == _state)
+    {
+        registerSubtree(subtree);
+        flush();
+    }
+}
+
+void AgentX::connect()
+{
+    const char* path = netsnmp_ds_get_string(NETSNMP_DS_APPLICATION_ID,
+                                             NETSNMP_DS_AGENT_X_SOCKET);
+    if (!path || !*path)
+    {
+        path = "/var/agentx/master";
+    }
+    if (0 == strncmp(path, "unix:", 5))
+    {
+        path += 5;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path[0] != '/' || strlen(path) >= sizeof(addr.sun_path))
+    {
+        TRACE_ERROR("AgentX engine supports unix sockets only, got '%s'\n",
+                    path);
+        return;
+    }
+    strcpy(addr.sun_path, path);
+
+    _io.reset();
+    _fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (_fd < 0 ||
+        0 != ::connect(_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)))
+    {
+        DEBUGMSGTL(("agentx:engine", "Can't connect to '%s': %s\n", path,
+                    strerror(errno)));
+        disconnect();
+        return;
+    }
+
+    _io = std::make_unique<sdeventplus::source::IO>(
+        *_event, _fd, EPOLLIN,
+        [this](sdeventplus::source::IO&, int, uint32_t events) {
+            onEvent(events);
+        });
+    _io->set_priority(Loop::requestPriority);
+
+    _state = State::Opening;
+    _openPacketId = ++_packetId;
+    Writer writer(_tx, OPEN, 0, 0, _openPacketId);
+    writer.u8(0); // Default timeout
+    writer.u8(0);
+    writer.u8(0);
+    writer.u8(0);
+    writer.objectId(nullptr, 0);
+    writer.octets(PACKAGE_NAME, strlen(PACKAGE_NAME));
+    send(writer);
+}
+
+void AgentX::disconnect()
+{
+    if (_io)
+    {
+        // Called by the source callback too, so the source is released
+        // by the next `connect()` or `destroy()`.
+        _io->set_enabled(sdeventplus::source::Enabled::Off);
+    }
+    if (_fd >= 0)
+    {
+        close(_fd);
+        _fd = -1;
+    }
+    _state = State::Closed;
+    _rx.clear();
+    _tx.clear();
+    _txOffset = 0;
+
+    if (_reconnect)
+    {
+        _reconnect->down();
+    }
+}
+
+void AgentX::onEvent(uint32_t events)
+{
+    if (events & EPOLLOUT)
+    {
+        flush();
+    }
+
+    if (events & EPOLLIN)
+    {
+        uint8_t chunk[4096];
+        for (;;)
+        {
+            auto bytes = read(_fd, chunk, sizeof(chunk));
+            if (bytes > 0)
+            {
+                _rx.insert(_rx.end(), chunk, chunk + bytes);
+                continue;
+            }
+            if (bytes < 0 && (EAGAIN == errno || EWOULDBLOCK == errno))
+            {
+                break;
+            }
+            TRACE_WARNING("AgentX session closed by the master\n");
+            disconnect();
+            return;
+        }
+        receive();
+    }
+    else if (events & (EPOLLHUP | EPOLLERR))
+    {
+        TRACE_WARNING("AgentX session lost\n");
+        disconnect();
+    }
+}
+
+void AgentX::receive()
+{
+    size_t offset = 0;
+    while (_fd >= 0 && _rx.size() - offset >= HEADER_SIZE)
+    {
+        Reader header(_rx.data() + offset, HEADER_SIZE);
+        if (!header.header() || header.payload > MAX_PAYLOAD)
+        {
+            TRACE_ERROR("AgentX engine: malformed PDU header\n");
+            disconnect();
+            return;
+        }
+
+        size_t size = HEADER_SIZE + header.payload;
+        if (_rx.size() - offset < size)
+        {
+            break;
+        }
+
+        // The PDU is parsed in place, nothing is copied out of the buffer.
+        Reader reader(_rx.data() + offset, size);
+        reader.header();
+        process(reader);
+        offset += size;
+    }
+
+    if (_fd >= 0)
+    {
+        _rx.erase(_rx.begin(), _rx.begin() + offset);
+    }
+}
+
+void AgentX::process(Reader& reader)
+{
+    switch (reader.type)
+    {
+        case RESPONSE:
+            onResponse(reader);
+            break;
+
+        case GET:
+        case GETNEXT:
+        case GETBULK:
+            onRequest(reader);
+            break;
+
+        case TESTSET:
+        case COMMITSET:
+        case UNDOSET:
+        {
+            // All subtrees are read-only.
+            Writer writer(_tx, RESPONSE, reader.sessionId,
+                          reader.transactionId, reader.packetId);
+            writer.u32(netsnmp_get_agent_uptime());
+            writer.u16(TESTSET == reader.type ? NOT_WRITABLE : NO_ERROR);
+            writer.u16(TESTSET == reader.type ? 1 : 0);
+            send(writer);
+        }
+        break;
+
+        case CLEANUPSET:
+            break;
+
+        case CLOSE:
+            TRACE_WARNING("AgentX session closed by the master\n");
+            disconnect();
+            break;
+
+        default:
+            DEBUGMSGTL(("agentx:engine", "Unsupported PDU type %u\n",
+                        reader.type));
+            break;
+    }
+}
+
+void AgentX::onResponse(Reader& reader)
+{
+    uint32_t uptime;
+    uint16_t error = 0;
+    uint16_t index = 0;
+    reader.u32(uptime);
+    reader.u16(error);
+    reader.u16(index);
+
+    if (State::Opening == _state && reader.packetId == _openPacketId)
+    {
+        if (NO_ERROR != error)
+        {
+            TRACE_ERROR("AgentX engine: open failed, error %u\n", error);
+            disconnect();
+            return;
+        }
+
+        _sessionId = reader.sessionId;
+        _state = State::Open;
+        ++_sessions;
+        _reconnect->up();
+        TRACE_INFO("AgentX engine: session %u opened, %zu subtrees\n",
+                   _sessionId, _subtrees.size());
+
+        // The rows are kept while the master is away, so the subtrees
+        // are served as soon as all registrations are sent in one write.
+        for (auto subtree : _subtrees)
+        {
+            registerSubtree(subtree);
+        }
+        flush();
+    }
+    else if (NO_ERROR != error)
+    {
+        TRACE_ERROR("AgentX engine: request %u failed, error %u\n",
+                    reader.packetId, error);
+    }
+}
+
+void AgentX::onRequest(Reader& reader)
+{
+    ++_requests;
+
+    if (reader.flags & NON_DEFAULT_CONTEXT)
+    {
+        reader.skipOctets();
+    }
+
+    uint16_t nonRepeaters = 0;
+    uint16_t maxRepetitions = 0;
+    if (GETBULK == reader.type)
+    {
+        reader.u16(nonRepeaters);
+        reader.u16(maxRepetitions);
+    }
+
+    size_t count = 0;
+    while (!reader.done())
+    {
+        if (_ranges.size() <= count)
+        {
+            _ranges.emplace_back();
+        }
+        auto& range = _ranges[count];
+        if (!reader.objectId(range.start, &range.include) ||
+            !reader.objectId(range.end))
+        {
+            break;
+        }
+        ++count;
+    }
+
+    Writer writer(_tx, RESPONSE, reader.sessionId, reader.transactionId,
+                  reader.packetId);
+    writer.u32(netsnmp_get_agent_uptime());
+    writer.u16(NO_ERROR);
+    writer.u16(0);
+
+    netsnmp_variable_list var{};
+    auto getNext = [&](Range& range) {
+        auto& start = range.start;
+        auto& end = range.end;
+        if (next(start.arcs.data(), start.length, range.include,
+                 end.arcs.data(), end.length, &var))
+        {
+            writer.varbind(&var);
+            // The following repetition starts from this instance.
+            std::copy(var.name, var.name + var.name_length,
+                      start.arcs.begin());
+            start.length = var.name_length;
+            range.include = false;
+            return true;
+        }
+        writer.exception(start.arcs.data(), start.length, END_OF_MIB_VIEW);
+        return false;
+    };
+
+    switch (reader.type)
+    {
+        case GET:
+            for (size_t i = 0; i < count; ++i)
+            {
+                auto& start = _ranges[i].start;
+                auto subtree = find(start.arcs.data(), start.length);
+                if (subtree &&
+                    subtree->get(start.arcs.data(), start.length, &var))
+                {
+                    snmp_set_var_objid(&var, start.arcs.data(), start.length);
+                    writer.varbind(&var);
+                }
+                else
+                {
+                    writer.exception(start.arcs.data(), start.length,
+                                     subtree ? NO_SUCH_INSTANCE
+                                             : NO_SUCH_OBJECT);
+                }
+            }
+            break;
+
+        case GETNEXT:
+            for (size_t i = 0; i < count; ++i)
+            {
+                getNext(_ranges[i]);
+            }
+            break;
+
+        case GETBULK:
+        {
+            size_t first = std::min<size_t>(nonRepeaters, count);
+            for (size_t i = 0; i < first; ++i)
+            {
+                getNext(_ranges[i]);
+            }
+
+            for (size_t r = 0; r < maxRepetitions && first < count &&
+                               writer.size() < MAX_RESPONSE;
+                 ++r)
+            {
+                bool more = false;
+                for (size_t i = first; i < count; ++i)
+                {
+                    more |= getNext(_ranges[i]);
+                }
+                if (!more)
+                {
+                    break;
+                }
+            }
+        }
+        break;
+    }
+
+    snmp_free_var_internals(&var);
+    _varbinds += count;
+    send(writer);
+}
+
+void AgentX::registerSubtree(const Subtree* subtree)
+{
+    Writer writer(_tx, REGISTER, _sessionId, 0, ++_packetId);
+    writer.u8(0);   // Session timeout
+    writer.u8(127); // Default priority
+    writer.u8(0);   // No range
+    writer.u8(0);
+    writer.objectId(subtree->root().data(), subtree->root().size());
+    writer.finish();
+}
+
+const Subtree* AgentX::find(const oid* name, size_t length) const
+{
+    for (auto subtree : _subtrees)
+    {
+        const auto& root = subtree->root();
+        if (0 == netsnmp_oid_is_subtree(root.data(), root.size(), name, length))
+        {
+            return subtree;
+        }
+    }
+    return nullptr;
+}
+
+bool AgentX::next(const oid* name, size_t length, bool include,
+                  const oid* end, size_t endLength,
+                  netsnmp_variable_list* var) const
+{
+    for (auto subtree : _subtrees)
+    {
+        const auto& root = subtree->root();
+        // Skip subtrees entirely before the OID.
+        if (snmp_oid_compare(name, length, root.data(), root.size()) > 0 &&
+            0 != netsnmp_oid_is_subtree(root.data(), root.size(), name, length))
+        {
+            continue;
+        }
+
+        if (subtree->next(name, length, include, var))
+        {
+            return 0 == endLength ||
+                   snmp_oid_compare(var->name, var->name_length, end,
+                                    endLength) < 0;
+        }
+    }
+    return false;
+}
+
+void AgentX::send(Writer& writer)
+{
+    writer.finish();
+    flush();
+}
+
+void AgentX::flush()
+{
+    while (_fd >= 0 && _txOffset < _tx.size())
+    {
+        auto bytes = write(_fd, _tx.data() + _txOffset, _tx.size() - _txOffset);
+        if (bytes < 0)
+        {
+            if (EAGAIN == errno || EWOULDBLOCK == errno)
+            {
+                _io->set_events(EPOLLIN | EPOLLOUT);
+                return;
+            }
+            TRACE_WARNING("AgentX engine: send failed: %s\n", strerror(errno));
+            disconnect();
+            return;
+        }
+        _txOffset += bytes;
+    }
+
+    if (_fd >= 0)
+    {
+        if (_io && (_io->get_events() & EPOLLOUT))
+        {
+            _io->set_events(EPOLLIN);
+        }
+        _tx.clear();
+        _txOffset = 0;
+    }
+}
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
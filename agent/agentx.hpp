@@ -0,0 +1,328 @@
+/**
+ * @brief Built-in AgentX subagent engine.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+
+#include "reconnect.hpp"
+#include "stats.hpp"
+
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/io.hpp>
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+/**
+ * @brief MIB subtree served by the AgentX engine.
+ */
+class Subtree
+{
+  public:
+    virtual ~Subtree() = default;
+
+    /**
+     * @brief Root OID, registered with the master agent.
+     */
+    const std::vector<oid>& root() const
+    {
+        return _root;
+    }
+
+    /**
+     * @brief Get value of the instance.
+     *
+     * @param name - Instance OID inside the subtree
+     * @param length - Instance OID length
+     * @param var - Variable to fill with the value
+     *
+     * @return false if there is no such instance.
+     */
+    virtual bool get(const oid* name, size_t length,
+                     netsnmp_variable_list* var) const = 0;
+
+    /**
+     * @brief Get the first instance following the OID.
+     *
+     * @param name - OID inside or before the subtree
+     * @param length - OID length
+     * @param include - Return instance equal to the OID
+     * @param var - Variable to fill with the instance OID and value
+     *
+     * @return false if there are no instances after the OID.
+     */
+    virtual bool next(const oid* name, size_t length, bool include,
+                      netsnmp_variable_list* var) const = 0;
+
+  protected:
+    std::vector<oid> _root;
+};
+
+/**
+ * @brief Single instance subtree.
+ */
+class Instance : public Subtree
+{
+  public:
+    using getter_t = std::function<void(netsnmp_variable_list*)>;
+
+    /**
+     * @brief Object constructor
+     *
+     * @param name - Instance OID
+     * @param length - Instance OID length
+     * @param getter - Value getter
+     * @param stats - Statistics of the served requests, optional
+     */
+    Instance(const oid* name, size_t length, getter_t&& getter,
+             ObjectStats* stats = nullptr) :
+        _getter(std::move(getter)),
+        _stats(stats)
+    {
+        _root.assign(name, name + length);
+    }
+
+    bool get(const oid* name, size_t length,
+             netsnmp_variable_list* var) const override
+    {
+        if (0 != snmp_oid_compare(name, length, _root.data(), _root.size()))
+        {
+            return false;
+        }
+        serve(ObjectStats::GET, var);
+        return true;
+    }
+
+    bool next(const oid* name, size_t length, bool include,
+              netsnmp_variable_list* var) const override
+    {
+        int cmp = snmp_oid_compare(name, length, _root.data(), _root.size());
+        if (cmp > 0 || (0 == cmp && !include))
+        {
+            return false;
+        }
+        snmp_set_var_objid(var, _root.data(), _root.size());
+        serve(ObjectStats::GETNEXT, var);
+        return true;
+    }
+
+  private:
+    void serve(ObjectStats::Mode mode, netsnmp_variable_list* var) const
+    {
+        auto start = ObjectStats::clock_t::now();
+        _getter(var);
+        if (_stats)
+        {
+            _stats->served(mode, start);
+        }
+    }
+
+    getter_t _getter;
+    ObjectStats* _stats;
+};
+
+/**
+ * @brief AgentX (RFC 2741) subagent engine on the event loop.
+ *
+ * Requests to the registered subtrees are parsed in place in the receive
+ * buffer and served directly by the subtree models, without net-snmp
+ * sessions, agent request lists and handler chains. Subtrees not served
+ * by the engine, and notifications, still go through the net-snmp
+ * subagent session.
+ */
+class AgentX
+{
+  public:
+    /**
+     * @brief Serve subtrees by the engine instead of net-snmp.
+     */
+    inline static bool enabled = false;
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Copy and move operations due to singleton.
+     *     Allowed:
+     *         - Default constructor.
+     *         - Destructor.
+     */
+    AgentX() = default;
+    AgentX(const AgentX&) = delete;
+    AgentX& operator=(const AgentX&) = delete;
+    AgentX(AgentX&&) = delete;
+    AgentX& operator=(AgentX&&) = delete;
+    ~AgentX() = default;
+
+    /**
+     * @brief Process-wide engine.
+     */
+    static AgentX& instance();
+
+    /**
+     * @brief Connect to the master agent if the engine is enabled.
+     */
+    void init(const sdeventplus::Event& event);
+
+    /**
+     * @brief Close the session.
+     */
+    void destroy();
+
+    /**
+     * @brief Serve the subtree, it should outlive the engine.
+     */
+    void add(Subtree* subtree);
+
+    /** @brief Number of served requests. */
+    uint64_t requests() const
+    {
+        return _requests;
+    }
+
+    /** @brief Number of served variables. */
+    uint64_t varbinds() const
+    {
+        return _varbinds;
+    }
+
+    /** @brief Number of sessions opened. */
+    uint64_t sessions() const
+    {
+        return _sessions;
+    }
+
+    /** @brief Reconnection state, nullptr if the engine is disabled. */
+    const Reconnect* reconnect() const
+    {
+        return _reconnect.get();
+    }
+
+  private:
+    class Reader;
+    class Writer;
+
+    /** @brief OID decoded from the PDU. */
+    struct OidBuffer
+    {
+        std::array<oid, MAX_OID_LEN> arcs;
+        size_t length = 0;
+    };
+
+    /** @brief Search range of the request. */
+    struct Range
+    {
+        OidBuffer start;
+        bool include;
+        OidBuffer end;
+    };
+
+    /** @brief Session state. */
+    enum class State
+    {
+        Closed,
+        Opening,
+        Open,
+    };
+
+    /** @brief Connect to the master and send Open PDU. */
+    void connect();
+
+    /**
+     * @brief Drop the connection and schedule reconnection.
+     *
+     * The IO source is only disabled, so this may be called by its
+     * callback.
+     */
+    void disconnect();
+
+    /** @brief IO source callback. */
+    void onEvent(uint32_t events);
+
+    /** @brief Parse complete PDUs of the receive buffer. */
+    void receive();
+
+    /** @brief Handle single PDU. */
+    void process(Reader& reader);
+
+    /** @brief Handle Response PDU. */
+    void onResponse(Reader& reader);
+
+    /** @brief Handle Get, GetNext and GetBulk PDUs. */
+    void onRequest(Reader& reader);
+
+    /** @brief Queue Register PDU for the subtree, `flush()` sends it. */
+    void registerSubtree(const Subtree* subtree);
+
+    /** @brief Find the subtree containing the OID. */
+    const Subtree* find(const oid* name, size_t length) const;
+
+    /**
+     * @brief Find the first instance after the OID and before the end.
+     *
+     * @return false if there are no instances in the range.
+     */
+    bool next(const oid* name, size_t length, bool include, const oid* end,
+              size_t endLength, netsnmp_variable_list* var) const;
+
+    /** @brief Queue the PDU being built for sending. */
+    void send(Writer& writer);
+
+    /** @brief Write queued data to the socket. */
+    void flush();
+
+    std::optional<sdeventplus::Event> _event;
+    std::unique_ptr<sdeventplus::source::IO> _io;
+    std::unique_ptr<Reconnect> _reconnect;
+    int _fd = -1;
+    State _state = State::Closed;
+    uint32_t _sessionId = 0;
+    uint32_t _packetId = 0;
+    uint32_t _openPacketId = 0;
+
+    // Subtrees in order of their root OIDs.
+    std::vector<Subtree*> _subtrees;
+
+    std::vector<uint8_t> _rx;
+    std::vector<uint8_t> _tx;
+    size_t _txOffset = 0;
+    // Search ranges of the current request, kept to reuse the memory.
+    std::vector<Range> _ranges;
+
+    uint64_t _requests = 0;
+    uint64_t _varbinds = 0;
+    uint64_t _sessions = 0;
+};
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
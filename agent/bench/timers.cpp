@@ -0,0 +1,133 @@
+/**
+ * @brief Microbenchmark of the shared timers.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "scheduler.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+using phosphor::snmp::agent::Scheduler;
+using phosphor::snmp::agent::Timer;
+using clock_type = std::chrono::steady_clock;
+
+/**
+ * @brief Print time per operation since the start.
+ */
+static void report(const char* what, clock_type::time_point start,
+                   size_t count)
+{
+    std::chrono::duration<double, std::nano> elapsed =
+        clock_type::now() - start;
+    printf("%-32s %10.1f ns/op\n", what, elapsed.count() / count);
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 100000;
+
+    auto event = sdeventplus::Event::get_new();
+    auto& scheduler = Scheduler::instance();
+    scheduler.init(event);
+
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> timeouts(1, 60000);
+    std::vector<std::chrono::milliseconds> delays(count);
+    for (auto& delay : delays)
+    {
+        delay = std::chrono::milliseconds{timeouts(random)};
+    }
+
+    size_t fired = 0;
+    std::vector<std::unique_ptr<Timer>> timers;
+    timers.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        timers.emplace_back(std::make_unique<Timer>([&fired]() { ++fired; }));
+    }
+
+    printf("%zu timers, timeouts 1 ms .. 60 s\n", count);
+
+    auto start = clock_type::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        timers[i]->start(delays[i]);
+    }
+    report("wheel: start", start, count);
+
+    start = clock_type::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        timers[i]->start(delays[count - i - 1]);
+    }
+    report("wheel: restart", start, count);
+
+    start = clock_type::now();
+    for (auto& timer : timers)
+    {
+        timer->stop();
+    }
+    report("wheel: stop", start, count);
+
+    // Ordered map of deadlines, the way the scheduler worked before.
+    std::multimap<clock_type::time_point, size_t> queue;
+    std::vector<decltype(queue)::iterator> positions(count);
+
+    start = clock_type::now();
+    for (size_t i = 0; i < count; ++i)
+    {
+        positions[i] = queue.emplace(clock_type::now() + delays[i], i);
+    }
+    report("multimap: start", start, count);
+
+    start = clock_type::now();
+    for (auto& it : positions)
+    {
+        queue.erase(it);
+    }
+    report("multimap: stop", start, count);
+
+    // Expiration: all timers within one second, served by the event loop.
+    std::uniform_int_distribution<int> shortTimeouts(1, 1000);
+    for (auto& timer : timers)
+    {
+        timer->start(std::chrono::milliseconds{shortTimeouts(random)});
+    }
+
+    start = clock_type::now();
+    size_t iterations = 0;
+    while (fired < count)
+    {
+        event.run(std::nullopt);
+        ++iterations;
+    }
+    std::chrono::duration<double, std::milli> elapsed =
+        clock_type::now() - start;
+    printf("expire: %zu timers in %.1f ms, %zu loop iterations\n", fired,
+           elapsed.count(), iterations);
+
+    timers.clear();
+    scheduler.destroy();
+    return EXIT_SUCCESS;
+}
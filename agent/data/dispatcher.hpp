@@ -0,0 +1,259 @@
+/**
+ * @brief Router of DBus ObjectManager signals to MIB tables.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include "sdbusplus/helper.hpp"
+#include "tracing.hpp"
+
+#include <functional>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace data
+{
+
+/**
+ * @brief Dispatcher of `InterfacesAdded` and `InterfacesRemoved` signals.
+ *
+ * Signals are matched by `arg0path` rules, so the agent is woken only
+ * for objects inside the subscribed folders. The object path is decoded
+ * once and the message is routed to the subscriber of the longest
+ * matching folder.
+ */
+class Dispatcher
+{
+  public:
+    /**
+     * @brief Signal handler.
+     *
+     * Receives the object path and the message positioned right after it.
+     */
+    using handler_t = std::function<void(const std::string& path,
+                                         sdbusplus::message::message& m)>;
+
+    /**
+     * @brief RAII subscription, unsubscribes the folder on destruction.
+     */
+    class Subscription
+    {
+      public:
+        Subscription() = delete;
+        Subscription(const Subscription&) = delete;
+        Subscription& operator=(const Subscription&) = delete;
+
+        Subscription(Subscription&& other) noexcept :
+            _folder(std::move(other._folder))
+        {
+            other._folder.clear();
+        }
+
+        Subscription& operator=(Subscription&& other) noexcept
+        {
+            std::swap(_folder, other._folder);
+            return *this;
+        }
+
+        ~Subscription()
+        {
+            if (!_folder.empty())
+            {
+                Dispatcher::instance().unsubscribe(_folder);
+            }
+        }
+
+      private:
+        friend class Dispatcher;
+
+        explicit Subscription(const std::string& folder) : _folder(folder)
+        {
+        }
+
+        std::string _folder;
+    };
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Copy and move operations due to `this` is bound
+     *           to signal handlers.
+     *     Allowed:
+     *         - Default constructor.
+     *         - Destructor.
+     */
+    Dispatcher() = default;
+    Dispatcher(const Dispatcher&) = delete;
+    Dispatcher& operator=(const Dispatcher&) = delete;
+    Dispatcher(Dispatcher&&) = delete;
+    Dispatcher& operator=(Dispatcher&&) = delete;
+    ~Dispatcher() = default;
+
+    /**
+     * @brief Process-wide dispatcher.
+     */
+    static Dispatcher& instance()
+    {
+        static Dispatcher dispatcher;
+        return dispatcher;
+    }
+
+    /**
+     * @brief Subscribe to signals about objects in the folder.
+     *
+     * @param folder - DBus folder
+     * @param added - `InterfacesAdded` handler
+     * @param removed - `InterfacesRemoved` handler
+     *
+     * @return Subscription object, inert if the folder is already
+     *         subscribed.
+     */
+    Subscription subscribe(const std::string& folder, handler_t&& added,
+                           handler_t&& removed)
+    {
+        auto result = _subscribers.emplace(
+            folder, Handlers{std::move(added), std::move(removed)});
+        if (!result.second)
+        {
+            TRACE_ERROR("data/dispatcher: Folder '%s' is already "
+                        "subscribed\n", folder.c_str());
+            return Subscription(std::string());
+        }
+        updateMatches();
+        return Subscription(folder);
+    }
+
+  private:
+    struct Handlers
+    {
+        handler_t added;
+        handler_t removed;
+    };
+
+    struct Matches
+    {
+        sdbusplus::bus::match::match added;
+        sdbusplus::bus::match::match removed;
+    };
+
+    void unsubscribe(const std::string& folder)
+    {
+        _subscribers.erase(folder);
+        updateMatches();
+    }
+
+    /**
+     * @brief Check if the path is equal to or inside the folder.
+     */
+    static bool isInside(const std::string& path, const std::string& folder)
+    {
+        return 0 == path.compare(0, folder.length(), folder) &&
+               (path.length() == folder.length() ||
+                path[folder.length()] == '/');
+    }
+
+    /**
+     * @brief Keep match rules only for top-level subscribed folders.
+     */
+    void updateMatches()
+    {
+        namespace rules = sdbusplus::bus::match::rules;
+
+        std::map<std::string, Matches> matches;
+        for (const auto& it : _subscribers)
+        {
+            const auto& folder = it.first;
+
+            // Subscribers are sorted, so the ancestor is checked first.
+            if (!matches.empty() && isInside(folder, matches.rbegin()->first))
+            {
+                continue;
+            }
+
+            auto old = _matches.find(folder);
+            if (old != _matches.end())
+            {
+                matches.emplace(folder, std::move(old->second));
+                continue;
+            }
+
+            // Trailing slash matches all objects under the folder.
+            auto arg0 = rules::argNpath(0, folder + "/");
+            auto& bus = sdbusplus::helper::helper::getBus();
+            matches.emplace(
+                folder,
+                Matches{{bus, rules::interfacesAdded() + arg0,
+                         [this](sdbusplus::message::message& m) {
+                             dispatch(m, &Handlers::added);
+                         }},
+                        {bus, rules::interfacesRemoved() + arg0,
+                         [this](sdbusplus::message::message& m) {
+                             dispatch(m, &Handlers::removed);
+                         }}});
+            DEBUGMSGTL(("data:dispatcher", "Watch folder '%s'\n",
+                        folder.c_str()));
+        }
+        _matches = std::move(matches);
+    }
+
+    /**
+     * @brief Route the signal to the subscriber of the longest folder.
+     */
+    void dispatch(sdbusplus::message::message& m, handler_t Handlers::*handler)
+    {
+        sdbusplus::message::object_path path;
+        try
+        {
+            m.read(path);
+        }
+        catch (const sdbusplus::exception::SdBusError& e)
+        {
+            TRACE_ERROR("data/dispatcher: Failed to parse signal data. "
+                        "ERROR='%s', PATH='%s', MEMBER='%s'\n",
+                        e.what(), m.get_path(), m.get_member());
+            return;
+        }
+
+        for (auto n = path.str.rfind('/'); n != 0 && n != std::string::npos;
+             n = path.str.rfind('/', n - 1))
+        {
+            auto it = _subscribers.find(path.str.substr(0, n));
+            if (it != _subscribers.end())
+            {
+                auto& callback = it->second.*handler;
+                if (callback)
+                {
+                    callback(path.str, m);
+                }
+                return;
+            }
+        }
+    }
+
+    std::map<std::string, Handlers> _subscribers;
+    std::map<std::string, Matches> _matches;
+};
+
+} // namespace data
+} // namespace snmp
+} // namespace phosphor
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <map>
 
 namespace phosphor
@@ -33,13 +34,14 @@ namespace data
 template <typename T> struct DBusEnum
 {
     std::string base;
-    std::map<std::string, T> values;
+    std::map<std::string, T, std::less<>> values;
     T wrongValue;
 
-    T get(const std::string& str) const
+    T get(std::string_view str) const
     {
         const auto len = base.length();
-        if (0 == str.compare(0, len, base))
+        if (str.length() > len && str[len] == '.' &&
+            0 == str.compare(0, len, base))
         {
             const auto& it = values.find(str.substr(len + 1));
             if (it != values.end())
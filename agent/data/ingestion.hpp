@@ -0,0 +1,436 @@
+/**
+ * @brief Decoding of DBus property changes outside of the main loop.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include "sdbusplus/helper.hpp"
+#include "loop.hpp"
+#include "tracing.hpp"
+
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/io.hpp>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace data
+{
+
+/**
+ * @brief Ingestion thread of `PropertiesChanged` signals.
+ *
+ * The thread has its own DBus connection and decodes the signals of
+ * the watched folders, so a burst of sensor updates doesn't delay SNMP
+ * requests. Decoded changes are published by the watchers themselves
+ * (see `Table`) and the main loop is woken to apply them in one go.
+ * The main thread keeps owning the items, so the request handlers
+ * read them without locks.
+ */
+class Ingestion
+{
+  public:
+    /**
+     * @brief Decode and publish the signal, called by the ingestion thread.
+     *
+     * @return false if the message is malformed.
+     */
+    using decoder_t = std::function<bool(sdbusplus::message::message& m)>;
+
+    /**
+     * @brief Apply published changes, called by the main thread.
+     */
+    using applier_t = std::function<void()>;
+
+    /**
+     * @brief Use the ingestion thread, set by `ingestThread` directive.
+     */
+    inline static bool enabled = false;
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Copy and move operations due to `this` is bound
+     *           to the thread and the event sources.
+     *     Allowed:
+     *         - Default constructor.
+     *         - Destructor.
+     */
+    Ingestion() = default;
+    Ingestion(const Ingestion&) = delete;
+    Ingestion& operator=(const Ingestion&) = delete;
+    Ingestion(Ingestion&&) = delete;
+    Ingestion& operator=(Ingestion&&) = delete;
+    ~Ingestion()
+    {
+        stop();
+    }
+
+    /**
+     * @brief Process-wide ingestion.
+     */
+    static Ingestion& instance()
+    {
+        static Ingestion ingestion;
+        return ingestion;
+    }
+
+    /**
+     * @brief Watch `PropertiesChanged` of objects inside the folder.
+     *
+     * The match is added to the thread connection at once, so the signals
+     * sent while the tables are populated wait there for `start()`.
+     * The folders watched after `start()` are decoded by the main loop.
+     *
+     * @param folder - DBus folder
+     * @param decode - Decoder of the signal
+     * @param apply - Applier of the decoded changes
+     */
+    void watch(const std::string& folder, decoder_t&& decode,
+               applier_t&& apply)
+    {
+        auto& watch = _watches.emplace_back(
+            Watch{folder, std::move(decode), std::move(apply)});
+        if (_fallback || _thread.joinable())
+        {
+            fallback(watch);
+            return;
+        }
+
+        try
+        {
+            if (!_bus)
+            {
+                setup();
+            }
+            subscribe(watch);
+        }
+        catch (const std::exception& e)
+        {
+            TRACE_ERROR("Failed to set up ingestion thread: %s\n", e.what());
+            cleanup();
+            fallback();
+        }
+    }
+
+    /**
+     * @brief Start the thread.
+     *
+     * If the thread can't be started or fails later, the signals are
+     * decoded by the main loop as usual.
+     *
+     * @param event - Main event loop to apply the changes
+     */
+    void start(const sdeventplus::Event& event)
+    {
+        if (_thread.joinable() || !_bus)
+        {
+            return;
+        }
+
+        try
+        {
+            _io = std::make_unique<sdeventplus::source::IO>(
+                event, _wakeup, EPOLLIN,
+                [this](sdeventplus::source::IO& source, int fd, uint32_t) {
+                    eventfd_t value;
+                    eventfd_read(fd, &value);
+                    _notified.store(false);
+                    if (_failed.load())
+                    {
+                        // The source can't be destroyed by its own
+                        // callback, it is released by `stop()`.
+                        source.set_enabled(
+                            sdeventplus::source::Enabled::Off);
+                        recover();
+                        return;
+                    }
+                    apply();
+                });
+            // Applied like the signals of the main connection.
+            _io->set_priority(agent::Loop::dbusPriority);
+
+            _thread = std::thread(&Ingestion::run, this);
+            TRACE_INFO("Ingestion thread started for %zu folders\n",
+                       _watches.size());
+            return;
+        }
+        catch (const std::exception& e)
+        {
+            TRACE_ERROR("Failed to start ingestion thread: %s\n", e.what());
+        }
+
+        cleanup();
+        fallback();
+    }
+
+    /**
+     * @brief Stop the thread, the changes not applied yet are dropped.
+     */
+    void stop()
+    {
+        bool started = _wakeup >= 0;
+        if (_thread.joinable())
+        {
+            eventfd_write(_exit, 1);
+            _thread.join();
+            if (!_error.empty())
+            {
+                TRACE_ERROR("Ingestion thread failed: %s\n", _error.c_str());
+            }
+        }
+        _error.clear();
+        cleanup();
+        if (started)
+        {
+            DEBUGMSGTL(("data:ingestion",
+                        "decoded=%llu, malformed=%llu, applied=%llu\n",
+                        static_cast<unsigned long long>(decoded()),
+                        static_cast<unsigned long long>(malformed()),
+                        static_cast<unsigned long long>(applied())));
+        }
+    }
+
+    /** @brief Number of signals decoded by the thread. */
+    uint64_t decoded() const
+    {
+        return _decoded.load(std::memory_order_relaxed);
+    }
+
+    /** @brief Number of malformed signals. */
+    uint64_t malformed() const
+    {
+        return _malformed.load(std::memory_order_relaxed);
+    }
+
+    /** @brief Number of times the main loop applied the changes. */
+    uint64_t applied() const
+    {
+        return _applied;
+    }
+
+  private:
+    struct Watch
+    {
+        std::string folder;
+        decoder_t decode;
+        applier_t apply;
+    };
+
+    /**
+     * @brief Create the thread event loop and connection.
+     *
+     * Done by the main thread, so the errors are reported as usual.
+     */
+    void setup()
+    {
+        _wakeup = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        _exit = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (_wakeup < 0 || _exit < 0)
+        {
+            throw std::system_error(errno, std::generic_category(),
+                                    "eventfd");
+        }
+
+        _event.emplace(sdeventplus::Event::get_new());
+        _bus.emplace(sdbusplus::bus::new_system());
+        _bus->attach_event(_event->get(), SD_EVENT_PRIORITY_NORMAL);
+        _exitIo = std::make_unique<sdeventplus::source::IO>(
+            *_event, _exit, EPOLLIN,
+            [](sdeventplus::source::IO& source, int, uint32_t) {
+                source.get_event().exit(0);
+            });
+    }
+
+    /**
+     * @brief Add the match of the folder to the thread connection.
+     */
+    void subscribe(const Watch& watch)
+    {
+        _matches.emplace_back(
+            *_bus,
+            sdbusplus::bus::match::rules::propertiesChangedNamespace(
+                watch.folder),
+            [this, decode = watch.decode](sdbusplus::message::message& m) {
+                if (!decode(m))
+                {
+                    _malformed.fetch_add(1, std::memory_order_relaxed);
+                }
+                _decoded.fetch_add(1, std::memory_order_relaxed);
+                notify();
+            });
+    }
+
+    /**
+     * @brief Thread body.
+     */
+    void run()
+    {
+        try
+        {
+            _event->loop();
+        }
+        catch (const std::exception& e)
+        {
+            // Reported by the main thread, the logging is not thread-safe.
+            _error = e.what();
+            _failed.store(true);
+            eventfd_write(_wakeup, 1);
+        }
+    }
+
+    /**
+     * @brief Switch to the main loop decoding after the thread failure.
+     */
+    void recover()
+    {
+        _thread.join();
+        TRACE_ERROR("Ingestion thread failed: %s, signals are decoded by "
+                    "the main loop\n",
+                    _error.c_str());
+        _error.clear();
+
+        apply();
+        release();
+        fallback();
+    }
+
+    /**
+     * @brief Wake the main loop unless it is already woken.
+     */
+    void notify()
+    {
+        if (!_notified.exchange(true))
+        {
+            eventfd_write(_wakeup, 1);
+        }
+    }
+
+    /**
+     * @brief Apply the changes published by the thread.
+     */
+    void apply()
+    {
+        ++_applied;
+        for (const auto& watch : _watches)
+        {
+            watch.apply();
+        }
+    }
+
+    /**
+     * @brief Decode the signals of all folders by the main loop.
+     */
+    void fallback()
+    {
+        _fallback = true;
+        for (const auto& watch : _watches)
+        {
+            fallback(watch);
+        }
+    }
+
+    /**
+     * @brief Decode the signals of the folder by the main loop.
+     */
+    void fallback(const Watch& watch)
+    {
+        _matches.emplace_back(
+            sdbusplus::helper::helper::getBus(),
+            sdbusplus::bus::match::rules::propertiesChangedNamespace(
+                watch.folder),
+            [&watch](sdbusplus::message::message& m) {
+                if (!watch.decode(m))
+                {
+                    TRACE_ERROR("data/ingestion: Failed to parse signal "
+                                "data. PATH='%s', MEMBER='%s'\n",
+                                m.get_path(), m.get_member());
+                }
+                watch.apply();
+            });
+    }
+
+    /**
+     * @brief Release the thread event loop and connection.
+     */
+    void release()
+    {
+        _matches.clear();
+        _exitIo.reset();
+        _bus.reset();
+        _event.reset();
+    }
+
+    /**
+     * @brief Release the thread resources.
+     */
+    void cleanup()
+    {
+        release();
+        _io.reset();
+        for (auto fd : {_wakeup, _exit})
+        {
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+        }
+        _wakeup = -1;
+        _exit = -1;
+    }
+
+    // Main thread only, the thread matches keep their own decoders.
+    std::list<Watch> _watches;
+
+    // Owned by the thread while it runs.
+    std::optional<sdeventplus::Event> _event;
+    std::optional<sdbusplus::bus::bus> _bus;
+    std::list<sdbusplus::bus::match::match> _matches;
+    std::unique_ptr<sdeventplus::source::IO> _exitIo;
+    std::string _error;
+
+    std::thread _thread;
+    int _wakeup = -1;
+    int _exit = -1;
+    std::unique_ptr<sdeventplus::source::IO> _io;
+    std::atomic<bool> _notified{false};
+    std::atomic<bool> _failed{false};
+    // The signals are decoded by the main loop.
+    bool _fallback = false;
+    std::atomic<uint64_t> _decoded{0};
+    std::atomic<uint64_t> _malformed{0};
+    uint64_t _applied = 0;
+};
+
+} // namespace data
+} // namespace snmp
+} // namespace phosphor
@@ -0,0 +1,181 @@
+/**
+ * @brief MIB tables population settings and statistics.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include "tracing.hpp"
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace data
+{
+
+/**
+ * @brief Common settings and progress of the tables population.
+ */
+struct Population
+{
+    using clock_t = std::chrono::steady_clock;
+
+    /**
+     * @brief How the DBus objects properties are fetched.
+     */
+    enum class Strategy
+    {
+        PerObject,      // `Properties.GetAll` for each object.
+        ManagedObjects, // `ObjectManager.GetManagedObjects` per service.
+    };
+
+    /**
+     * @brief Max number of DBus requests simultaneously in flight per table.
+     *
+     * Zero means synchronous population.
+     */
+    inline static size_t window = 0;
+
+    /**
+     * @brief Population strategy.
+     *
+     * Services without ObjectManager are always queried per object.
+     */
+    inline static Strategy strategy = Strategy::ManagedObjects;
+
+    /**
+     * @brief Called when a table starts the population.
+     *
+     * @return Start time of the table population.
+     */
+    static clock_t::time_point begin()
+    {
+        auto now = clock_t::now();
+        if (0 == active++)
+        {
+            started = now;
+        }
+        return now;
+    }
+
+    /**
+     * @brief Called when a table finishes the population.
+     *
+     * @param path - DBus folder of the table
+     * @param objects - Number of fetched DBus objects
+     * @param since - Start time of the table population
+     */
+    static void end(const std::string& path, size_t objects,
+                    clock_t::time_point since)
+    {
+        auto now = clock_t::now();
+        DEBUGMSGTL(("data:population", "'%s' populated: %zu objects in %lld ms\n",
+                    path.c_str(), objects, toMsec(now - since)));
+
+        if (active > 0 && 0 == --active)
+        {
+            complete(now);
+        }
+    }
+
+    /**
+     * @brief Keep the initial population incomplete until `release()`.
+     *
+     * Called before the tables are registered, so the initial population
+     * isn't reported complete after the first synchronous table.
+     */
+    static void hold()
+    {
+        begin();
+    }
+
+    /**
+     * @brief Release the hold taken by `hold()`.
+     */
+    static void release()
+    {
+        if (active > 0 && 0 == --active)
+        {
+            complete(clock_t::now());
+        }
+    }
+
+    /**
+     * @brief Call the function once the initial population is complete.
+     *
+     * The function is called immediately if it is already complete.
+     */
+    static void whenInitialized(std::function<void()>&& callback)
+    {
+        if (initialized)
+        {
+            callback();
+            return;
+        }
+        callbacks.emplace_back(std::move(callback));
+    }
+
+    /**
+     * @brief Number of tables in progress of population.
+     */
+    inline static size_t active = 0;
+
+    /**
+     * @brief Start time of the first table in progress.
+     */
+    inline static clock_t::time_point started;
+
+    /**
+     * @brief Initial population of all tables is complete.
+     */
+    inline static bool initialized = false;
+
+  private:
+    static void complete(clock_t::time_point now)
+    {
+        TRACE_INFO("All tables populated in %lld ms\n", toMsec(now - started));
+
+        if (!initialized)
+        {
+            initialized = true;
+            auto pending = std::move(callbacks);
+            for (auto& callback : pending)
+            {
+                callback();
+            }
+        }
+    }
+
+    inline static std::vector<std::function<void()>> callbacks;
+
+    static long long toMsec(clock_t::duration d)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(d)
+            .count();
+    }
+};
+
+} // namespace data
+} // namespace snmp
+} // namespace phosphor
@@ -22,6 +22,7 @@
 
 #include "sdbusplus/helper.hpp"
 #include <memory>
+#include <optional>
 
 namespace phosphor
 {
@@ -55,20 +56,27 @@ template <typename T> class Scalar
     Scalar(const std::string& path, const std::string& iface,
            const std::string& prop, const T& initValue) :
         _value(initValue),
-        _path(path), _iface(iface), _prop(prop),
-        _onChangedMatch(sdbusplus::helper::helper::getBus(),
-                        sdbusplus::bus::match::rules::propertiesChanged(
-                            path.c_str(), iface.c_str()),
-                        std::bind(&Scalar<T>::onPropertyChanged, this,
-                                  std::placeholders::_1))
+        _path(path), _iface(iface), _prop(prop)
     {
     }
 
     /**
      * @brief Sent request to DBus object and store new value of property
+     *
+     * The property changes are watched since the first update.
      */
     void update()
     {
+        if (!_onChangedMatch)
+        {
+            _onChangedMatch.emplace(
+                sdbusplus::helper::helper::getBus(),
+                sdbusplus::bus::match::rules::propertiesChanged(
+                    _path.c_str(), _iface.c_str()),
+                std::bind(&Scalar<T>::onPropertyChanged, this,
+                          std::placeholders::_1));
+        }
+
         try
         {
             auto service = sdbusplus::helper::helper::getService(_path, _iface);
@@ -142,7 +150,7 @@ template <typename T> class Scalar
     std::string _iface;
     std::string _prop;
 
-    sdbusplus::bus::match::match _onChangedMatch;
+    std::optional<sdbusplus::bus::match::match> _onChangedMatch;
 };
 
 } // namespace data
@@ -21,10 +21,23 @@
 #pragma once
 
 #include "sdbusplus/helper.hpp"
+#include "agentx.hpp"
+#include "stats.hpp"
+#include "data/dispatcher.hpp"
+#include "data/ingestion.hpp"
+#include "data/population.hpp"
 #include <net-snmp/net-snmp-config.h>
 #include <net-snmp/net-snmp-includes.h>
 #include <net-snmp/agent/net-snmp-agent-includes.h>
 
+#include <climits>
+#include <deque>
+#include <list>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+
 namespace phosphor
 {
 namespace snmp
@@ -35,7 +48,7 @@ namespace data
 /**
  * @brief MIB Table implementation.
  */
-template <typename ItemType> class Table
+template <typename ItemType> class Table : public agent::Subtree
 {
   public:
     using interfaces_t = std::vector<std::string>;
@@ -64,50 +77,64 @@ template <typename ItemType> class Table
     Table(const std::string& folder, const interfaces_t interfaces = {}) :
         _path(folder), _interfaces(interfaces)
     {
-        _matches.emplace_back(sdbusplus::helper::helper::getBus(),
-                              sdbusplus::bus::match::rules::interfacesAdded(),
-                              std::bind(&Table<ItemType>::onInterfacesAdded,
-                                        this, std::placeholders::_1));
-        _matches.emplace_back(sdbusplus::helper::helper::getBus(),
-                              sdbusplus::bus::match::rules::interfacesRemoved(),
-                              std::bind(&Table<ItemType>::onInterfacesRemoved,
-                                        this, std::placeholders::_1));
     }
 
     /**
      * @brief Force update table items
+     *
+     * Depending on `Population::window` the items are fetched either
+     * synchronously or with up to `window` requests in flight.
+     * DBus signals of the folder are watched since the first update.
      */
     void update()
     {
-        auto data = sdbusplus::helper::helper::getSubTree(_path, _interfaces);
+        watch();
 
-        // Drop sensors if it not present in answer
-        auto path = _path + "/";
-        for (auto it = _items.begin(); it != _items.end();)
+        if (Population::window > 0)
         {
-            if (data.find(path + (*it)->name) == data.end())
-            {
-                it = dropItem(it);
-            }
-            else
-            {
-                ++it;
-            }
+            updateAsync();
+            return;
         }
 
-        // Update existing and create new items.
-        using fields_map_t = typename ItemType::fields_map_t;
-        for (const auto& pi : data)
+        auto since = Population::begin();
+        _subtree = sdbusplus::helper::helper::getSubTree(_path, _interfaces);
+        Objects managers;
+        if (Population::strategy == Population::Strategy::ManagedObjects &&
+            !_subtree.empty())
         {
-            for (const auto& bi : pi.second)
+            managers = sdbusplus::helper::helper::getAncestors(
+                _subtree.begin()->first,
+                {sdbusplus::helper::OBJECT_MANAGER_IFACE});
+        }
+        plan(managers);
+
+        while (!_queue.empty())
+        {
+            auto request = std::move(_queue.front());
+            _queue.pop_front();
+
+            try
+            {
+                auto reply =
+                    request.bulk
+                        ? sdbusplus::helper::helper::callMethod(
+                              request.service, request.path,
+                              sdbusplus::helper::OBJECT_MANAGER_IFACE,
+                              "GetManagedObjects")
+                        : sdbusplus::helper::helper::callMethod(
+                              request.service, request.path,
+                              sdbusplus::helper::PROPERTIES_IFACE, "GetAll",
+                              "");
+                onReply(request, reply);
+            }
+            catch (const sdbusplus::exception::SdBusError& e)
             {
-                auto fields =
-                    sdbusplus::helper::helper::callMethodAndRead<fields_map_t>(
-                        bi.first, pi.first, sdbusplus::helper::PROPERTIES_IFACE,
-                        "GetAll", "");
-                getItem(pi.first).setFields(fields);
+                onError(request, e.what());
             }
         }
+
+        Population::end(_path, _subtree.size(), since);
+        _subtree.clear();
     }
 
     /**
@@ -118,13 +145,31 @@ template <typename ItemType> class Table
      * @param table_oid_len - Table OID length
      * @param min_column - Minimum columns number
      * @param max_column - Maximum columns number
+     *
+     * The table is served by the built-in AgentX engine if it is enabled.
+     * DBus signals are watched from now on if not yet, so the tables
+     * of the modules not served by the process don't get them.
      */
     void init_mib(const char* name, const oid* table_oid, size_t table_oid_len,
                   size_t min_column, size_t max_column)
     {
+        watch();
+
+        _stats->name = name;
+        _root.assign(table_oid, table_oid + table_oid_len);
+        _minColumn = min_column;
+        _maxColumn = max_column;
+
+        if (agent::AgentX::enabled)
+        {
+            agent::AgentX::instance().add(this);
+            return;
+        }
+
         netsnmp_handler_registration* reg = netsnmp_create_handler_registration(
             name, Table<ItemType>::snmp_handler, table_oid, table_oid_len,
             HANDLER_CAN_RONLY);
+        reg->handler->myvoid = this;
 
         netsnmp_table_registration_info* table_info =
             SNMP_MALLOC_TYPEDEF(netsnmp_table_registration_info);
@@ -132,69 +177,656 @@ template <typename ItemType> class Table
         table_info->min_column = min_column;
         table_info->max_column = max_column;
 
-        netsnmp_iterator_info* iinfo =
-            SNMP_MALLOC_TYPEDEF(netsnmp_iterator_info);
-        iinfo->get_first_data_point = Table<ItemType>::get_first_data_point;
-        iinfo->get_next_data_point = Table<ItemType>::get_next_data_point;
-        iinfo->table_reginfo = table_info;
-        iinfo->myvoid = this;
+        netsnmp_register_table(reg, table_info);
+    }
+
+    /**
+     * @brief Get the cell, the OID is `table.1.column.index`.
+     */
+    bool get(const oid* name, size_t length,
+             netsnmp_variable_list* var) const override
+    {
+        auto start = agent::ObjectStats::clock_t::now();
+        bool found = getCell(name, length, var);
+        _stats->served(agent::ObjectStats::GET, start);
+        return found;
+    }
 
-        netsnmp_register_table_iterator(reg, iinfo);
+    /**
+     * @brief Get the cell following the OID, walking columns in order.
+     *
+     * The request is counted only if the table answers it, otherwise
+     * the engine continues with the following subtree.
+     */
+    bool next(const oid* name, size_t length, bool include,
+              netsnmp_variable_list* var) const override
+    {
+        auto start = agent::ObjectStats::clock_t::now();
+        bool found = nextCell(name, length, include, var);
+        if (found)
+        {
+            _stats->served(agent::ObjectStats::GETNEXT, start);
+        }
+        return found;
+    }
+
+    /**
+     * @brief Number of table rows.
+     */
+    size_t size() const
+    {
+        return _items.size();
+    }
+
+    /**
+     * @brief Call the function for each row in order of indexes.
+     */
+    template <typename Func> void forEach(Func&& func) const
+    {
+        for (const auto& item : _items)
+        {
+            func(*item);
+        }
     }
 
   protected:
     using ItemPtr = std::unique_ptr<ItemType>;
     using Items = std::vector<ItemPtr>;
+    using Objects = sdbusplus::helper::helper::Objects;
+    using fields_t = typename ItemType::fields_t;
+    // Changes decoded by the ingestion thread, by item names.
+    using Batch = std::unordered_map<std::string, fields_t>;
 
     /**
-     * @brief DBus signal `InterfacesAdded` handler.
+     * @brief Population request.
      */
-    void onInterfacesAdded(sdbusplus::message::message& m)
+    struct Request
     {
-        using Data = std::map<std::string, typename ItemType::fields_map_t>;
+        std::string service;
+        std::string path;
+        bool bulk; // `GetManagedObjects` if true, `GetAll` otherwise.
+    };
 
-        sdbusplus::message::object_path path;
-        Data data;
-        m.read(path, data);
+    /**
+     * @brief Get the cell for `get()`.
+     */
+    bool getCell(const oid* name, size_t length,
+                 netsnmp_variable_list* var) const
+    {
+        auto root = _root.size();
+        if (length < root + 3 || name[root] != 1 ||
+            name[root + 1] < _minColumn || name[root + 1] > _maxColumn)
+        {
+            return false;
+        }
 
-        if (0 == path.str.compare(0, _path.length(), _path))
+        auto idx = name + root + 2;
+        auto len = length - root - 2;
+        if (idx[0] != len - 1)
         {
-            // Skip unnecessary objects
-            bool isOwned = _interfaces.empty();
-            if (!isOwned)
+            return false;
+        }
+
+        char key[MAX_OID_LEN];
+        for (size_t i = 1; i < len; ++i)
+        {
+            if (idx[i] > UCHAR_MAX)
+            {
+                return false;
+            }
+            key[i - 1] = static_cast<char>(idx[i]);
+        }
+
+        auto it = _index.find(std::string_view(key, len - 1));
+        return it != _index.end() &&
+               it->second->get_value(static_cast<int>(name[root + 1]), var);
+    }
+
+    /**
+     * @brief Get the cell following the OID for `next()`.
+     */
+    bool nextCell(const oid* name, size_t length, bool include,
+                  netsnmp_variable_list* var) const
+    {
+        auto root = _root.size();
+        size_t column = _minColumn;
+        auto it = _items.begin();
+
+        if (0 == netsnmp_oid_is_subtree(_root.data(), root, name, length))
+        {
+            auto suffix = name + root;
+            auto len = length - root;
+            if (len > 0 && suffix[0] > 1)
+            {
+                return false;
+            }
+            if (len > 1 && suffix[0] == 1 && suffix[1] >= _minColumn)
+            {
+                if (suffix[1] > _maxColumn)
+                {
+                    return false;
+                }
+                column = suffix[1];
+                it = lowerBound(suffix + 2, len - 2, include);
+            }
+        }
+        else if (snmp_oid_compare(name, length, _root.data(), root) > 0)
+        {
+            return false;
+        }
+
+        if (_items.empty())
+        {
+            return false;
+        }
+
+        for (; column <= _maxColumn; ++column, it = _items.begin())
+        {
+            for (; it != _items.end(); ++it)
+            {
+                const auto& item = *it;
+                auto size = root + 3 + item->name.length();
+                if (size > MAX_OID_LEN)
+                {
+                    continue;
+                }
+                if (!item->get_value(static_cast<int>(column), var))
+                {
+                    break; // Column is not supported
+                }
+
+                oid instance[MAX_OID_LEN];
+                std::copy(_root.begin(), _root.end(), instance);
+                instance[root] = 1;
+                instance[root + 1] = column;
+                instance[root + 2] = item->name.length();
+                for (size_t i = 0; i < item->name.length(); ++i)
+                {
+                    instance[root + 3 + i] =
+                        static_cast<unsigned char>(item->name[i]);
+                }
+                snmp_set_var_objid(var, instance, size);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Subscribe to DBus signals about objects of the folder.
+     *
+     * `PropertiesChanged` is decoded by the ingestion thread if enabled.
+     */
+    void watch()
+    {
+        if (_subscription)
+        {
+            return;
+        }
+
+        _subscription.emplace(Dispatcher::instance().subscribe(
+            _path,
+            std::bind(&Table<ItemType>::onInterfacesAdded, this,
+                      std::placeholders::_1, std::placeholders::_2),
+            std::bind(&Table<ItemType>::onInterfacesRemoved, this,
+                      std::placeholders::_1, std::placeholders::_2)));
+
+        if (Ingestion::enabled)
+        {
+            Ingestion::instance().watch(
+                _path,
+                std::bind(&Table<ItemType>::ingest, this,
+                          std::placeholders::_1),
+                std::bind(&Table<ItemType>::applyIngested, this));
+            return;
+        }
+
+        _matches.emplace_back(
+            sdbusplus::helper::helper::getBus(),
+            sdbusplus::bus::match::rules::propertiesChangedNamespace(_path),
+            std::bind(&Table<ItemType>::onPropertiesChanged, this,
+                      std::placeholders::_1));
+    }
+
+    /**
+     * @brief Drop items which are not present in the mapper answer.
+     */
+    void dropMissing(const Objects& data)
+    {
+        auto path = _path + "/";
+        for (auto it = _items.begin(); it != _items.end();)
+        {
+            if (data.find(path + (*it)->name) == data.end())
+            {
+                it = dropItem(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    /**
+     * @brief Find the object manager path covering the whole table folder.
+     *
+     * @param managers - Ancestors implementing ObjectManager
+     * @param service - DBus service name
+     *
+     * @return Path of the deepest suitable object manager or empty string.
+     */
+    std::string findManager(const Objects& managers,
+                            const std::string& service) const
+    {
+        std::string found;
+        for (const auto& [path, services] : managers)
+        {
+            bool covers = path == "/" || path == _path ||
+                          (0 == _path.compare(0, path.length(), path) &&
+                           _path[path.length()] == '/');
+            if (covers && path.length() > found.length() &&
+                services.find(service) != services.end())
+            {
+                found = path;
+            }
+        }
+        return found;
+    }
+
+    /**
+     * @brief Queue population requests for the stored mapper answer.
+     *
+     * Objects are grouped by owning service, services implementing
+     * ObjectManager are queried with single bulk request.
+     *
+     * @param managers - Mapper `GetAncestors` answer for ObjectManager
+     */
+    void plan(const Objects& managers)
+    {
+        dropMissing(_subtree);
+        _queue.clear();
+
+        std::map<std::string, std::vector<std::string>> services;
+        for (const auto& [path, owners] : _subtree)
+        {
+            for (const auto& owner : owners)
+            {
+                services[owner.first].push_back(path);
+            }
+        }
+
+        for (const auto& [service, paths] : services)
+        {
+            auto manager = findManager(managers, service);
+            if (!manager.empty())
+            {
+                _queue.push_back({service, manager, true});
+            }
+            else
+            {
+                for (const auto& path : paths)
+                {
+                    _queue.push_back({service, path, false});
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Queue per-object requests for all objects of the service.
+     *
+     * Used if bulk request to the service failed.
+     */
+    void fallback(const std::string& service)
+    {
+        for (const auto& [path, owners] : _subtree)
+        {
+            if (owners.find(service) != owners.end())
+            {
+                _queue.push_back({service, path, false});
+            }
+        }
+    }
+
+    /**
+     * @brief Handle failed population request.
+     */
+    void onError(const Request& request, const char* what)
+    {
+        TRACE_ERROR("data/table: Failed to get '%s' from '%s': %s\n",
+                    request.path.c_str(), request.service.c_str(), what);
+        if (request.bulk)
+        {
+            fallback(request.service);
+        }
+    }
+
+    /**
+     * @brief Handle population request reply.
+     */
+    void onReply(const Request& request, sdbusplus::message::message& m)
+    {
+        if (m.is_method_error())
+        {
+            onError(request, "method error");
+            return;
+        }
+
+        try
+        {
+            if (request.bulk)
+            {
+                sdbusplus::helper::MessageReader reader(m);
+
+                reader.enter(SD_BUS_TYPE_ARRAY, "{oa{sa{sv}}}");
+                while (reader.enter(SD_BUS_TYPE_DICT_ENTRY, "oa{sa{sv}}"))
+                {
+                    const char* path = nullptr;
+                    reader.read(SD_BUS_TYPE_OBJECT_PATH, path);
+
+                    // Skip objects out of table or owned by other services.
+                    auto it = _subtree.find(path);
+                    if (it == _subtree.end() ||
+                        it->second.find(request.service) == it->second.end())
+                    {
+                        reader.skip("a{sa{sv}}");
+                    }
+                    else
+                    {
+                        reader.enter(SD_BUS_TYPE_ARRAY, "{sa{sv}}");
+                        setFields(getItem(it->first), reader, m);
+                        reader.exit();
+                    }
+                    reader.exit();
+                }
+                reader.exit();
+            }
+            else
+            {
+                fields_t fields;
+                ItemType::decodeFields(m, ItemType::schema, fields);
+                getItem(request.path).setFields(fields);
+            }
+        }
+        catch (const sdbusplus::exception::SdBusError& e)
+        {
+            onError(request, e.what());
+        }
+    }
+
+    /**
+     * @brief Set item fields from all interfaces of `a{sa{sv}}` dictionary.
+     *
+     * Properties of all interfaces are merged into a single update.
+     *
+     * @param item - Table item
+     * @param reader - Reader of the message, entered into the dictionary
+     * @param m - Message
+     */
+    static void setFields(ItemType& item,
+                          sdbusplus::helper::MessageReader& reader,
+                          sdbusplus::message::message& m)
+    {
+        fields_t fields;
+        while (reader.enter(SD_BUS_TYPE_DICT_ENTRY, "sa{sv}"))
+        {
+            const char* iface = nullptr;
+            reader.read(SD_BUS_TYPE_STRING, iface);
+            ItemType::decodeFields(m, ItemType::schema, fields);
+            reader.exit();
+        }
+        item.setFields(fields);
+    }
+
+    /**
+     * @brief Check if any of interfaces of `a{sa{sv}}` dictionary
+     *        is required by the table.
+     *
+     * @param reader - Reader of the message, entered into the dictionary
+     */
+    bool isOwned(sdbusplus::helper::MessageReader& reader) const
+    {
+        if (_interfaces.empty())
+        {
+            return true;
+        }
+
+        bool owned = false;
+        while (!owned && reader.enter(SD_BUS_TYPE_DICT_ENTRY, "sa{sv}"))
+        {
+            const char* iface = nullptr;
+            reader.read(SD_BUS_TYPE_STRING, iface);
+            owned = std::find(_interfaces.begin(), _interfaces.end(), iface) !=
+                    _interfaces.end();
+            reader.skip("a{sv}");
+            reader.exit();
+        }
+        return owned;
+    }
+
+    /**
+     * @brief Start asynchronous update of table items.
+     *
+     * Previous update (if any) is cancelled.
+     */
+    void updateAsync()
+    {
+        _calls.clear();
+        _queue.clear();
+        _inflight = 0;
+
+        if (!_populating)
+        {
+            _populating = true;
+            _since = Population::begin();
+        }
+
+        auto& cache = sdbusplus::helper::helper::getMapperCache();
+        if (auto cached = cache.findSubTree(_path, _interfaces, 0))
+        {
+            _subtree = *cached;
+            requestManagers();
+            return;
+        }
+
+        try
+        {
+            _calls.emplace_back(
+                std::bind(&Table<ItemType>::onSubTree, this,
+                          std::placeholders::_1),
+                sdbusplus::helper::OBJECT_MAPPER_IFACE,
+                sdbusplus::helper::OBJECT_MAPPER_PATH,
+                sdbusplus::helper::OBJECT_MAPPER_IFACE, "GetSubTree", _path,
+                int32_t(0), _interfaces);
+        }
+        catch (const sdbusplus::exception::SdBusError& e)
+        {
+            TRACE_ERROR("data/table: Failed to request subtree '%s': %s\n",
+                        _path.c_str(), e.what());
+            finishAsync();
+        }
+    }
+
+    /**
+     * @brief Reply handler of asynchronous `GetSubTree` request.
+     */
+    void onSubTree(sdbusplus::message::message& m)
+    {
+        _subtree.clear();
+        if (!m.is_method_error())
+        {
+            try
+            {
+                m.read(_subtree);
+            }
+            catch (const sdbusplus::exception::SdBusError& e)
             {
-                auto it = std::find_first_of(
-                    _interfaces.begin(), _interfaces.end(), data.begin(),
-                    data.end(),
-                    [](const std::string& iface,
-                       const typename Data::value_type& item) {
-                        return iface == item.first;
-                    });
-                isOwned = (it != _interfaces.end());
+                TRACE_ERROR("data/table: Failed to parse subtree '%s': %s\n",
+                            _path.c_str(), e.what());
             }
+        }
+
+        if (!_subtree.empty())
+        {
+            sdbusplus::helper::helper::getMapperCache().addSubTree(
+                _path, _interfaces, 0, _subtree);
+        }
 
-            if (isOwned)
+        requestManagers();
+    }
+
+    /**
+     * @brief Request object managers covering the table folder.
+     */
+    void requestManagers()
+    {
+        if (Population::strategy == Population::Strategy::ManagedObjects &&
+            !_subtree.empty())
+        {
+            try
             {
-                auto& item = getItem(path.str);
+                _calls.emplace_back(
+                    [this](sdbusplus::message::message& m) {
+                        Objects managers;
+                        if (!m.is_method_error())
+                        {
+                            try
+                            {
+                                m.read(managers);
+                            }
+                            catch (const sdbusplus::exception::SdBusError&)
+                            {
+                                // Fall back to per-object requests
+                            }
+                        }
+                        plan(managers);
+                        requestFields();
+                    },
+                    sdbusplus::helper::OBJECT_MAPPER_IFACE,
+                    sdbusplus::helper::OBJECT_MAPPER_PATH,
+                    sdbusplus::helper::OBJECT_MAPPER_IFACE, "GetAncestors",
+                    _subtree.begin()->first,
+                    interfaces_t{sdbusplus::helper::OBJECT_MANAGER_IFACE});
+                return;
+            }
+            catch (const sdbusplus::exception::SdBusError& e)
+            {
+                TRACE_ERROR("data/table: Failed to request managers of "
+                            "'%s': %s\n",
+                            _path.c_str(), e.what());
+            }
+        }
 
-                for (const auto& [iface, fields] : data)
+        plan({});
+        requestFields();
+    }
+
+    /**
+     * @brief Send queued requests while the window is not full.
+     */
+    void requestFields()
+    {
+        while (_inflight < Population::window && !_queue.empty())
+        {
+            auto request = std::move(_queue.front());
+            _queue.pop_front();
+
+            try
+            {
+                auto callback = [this, request](sdbusplus::message::message& m) {
+                    --_inflight;
+                    onReply(request, m);
+                    requestFields();
+                };
+
+                if (request.bulk)
                 {
-                    item.setFields(fields);
+                    _calls.emplace_back(std::move(callback), request.service,
+                                        request.path,
+                                        sdbusplus::helper::OBJECT_MANAGER_IFACE,
+                                        "GetManagedObjects");
                 }
+                else
+                {
+                    _calls.emplace_back(std::move(callback), request.service,
+                                        request.path,
+                                        sdbusplus::helper::PROPERTIES_IFACE,
+                                        "GetAll", "");
+                }
+                ++_inflight;
+            }
+            catch (const sdbusplus::exception::SdBusError& e)
+            {
+                onError(request, e.what());
             }
         }
+
+        if (0 == _inflight && _queue.empty())
+        {
+            finishAsync();
+        }
+    }
+
+    /**
+     * @brief Complete asynchronous update and report population time.
+     */
+    void finishAsync()
+    {
+        if (_populating)
+        {
+            _populating = false;
+            Population::end(_path, _subtree.size(), _since);
+        }
+        _subtree.clear();
+        // Completed calls are released here, the current one is still
+        // valid while its callback returns (see AsyncCall::handler).
+        _calls.clear();
+    }
+
+    /**
+     * @brief DBus signal `InterfacesAdded` handler.
+     *
+     * @param path - Object path inside the table folder
+     * @param m - Signal message positioned after the object path
+     */
+    void onInterfacesAdded(const std::string& path,
+                           sdbusplus::message::message& m)
+    {
+        try
+        {
+            sdbusplus::helper::MessageReader reader(m);
+
+            reader.enter(SD_BUS_TYPE_ARRAY, "{sa{sv}}");
+            // Skip unnecessary objects
+            if (isOwned(reader))
+            {
+                reader.rewind();
+                setFields(getItem(path), reader, m);
+            }
+            reader.exit();
+        }
+        catch (const sdbusplus::exception::SdBusError& e)
+        {
+            TRACE_ERROR("data/table: Failed to parse signal data. "
+                        "ERROR='%s', PATH='%s', MEMBER='%s', "
+                        "object path='%s'\n",
+                        e.what(), m.get_path(), m.get_member(), path.c_str());
+        }
     }
 
     /**
      * @brief DBus signal `InterfacesRemoved` handler.
+     *
+     * @param path - Object path inside the table folder
+     * @param m - Signal message positioned after the object path
      */
-    void onInterfacesRemoved(sdbusplus::message::message& m)
+    void onInterfacesRemoved(const std::string& path,
+                             sdbusplus::message::message& m)
     {
-        sdbusplus::message::object_path path;
         std::vector<std::string> data;
         try
         {
-            m.read(path, data);
+            m.read(data);
         }
         catch (const sdbusplus::exception::SdBusError& e)
         {
@@ -202,40 +834,172 @@ template <typename ItemType> class Table
                         "ERROR='%s', REPLY_SIG='%s', PATH='%s', "
                         "IFACE='%s', MEMBER='%s', object path='%s'\n",
                         e.what(), m.get_signature(), m.get_path(),
-                        m.get_interface(), m.get_member(), path.str.c_str());
+                        m.get_interface(), m.get_member(), path.c_str());
+        }
+
+        bool isOwned = _interfaces.empty();
+        if (!isOwned)
+        {
+            auto it = std::find_first_of(_interfaces.begin(), _interfaces.end(),
+                                         data.begin(), data.end());
+            isOwned = (it != _interfaces.end());
+        }
+
+        if (isOwned)
+        {
+            dropItem(path);
         }
+    }
 
-        if (0 == path.str.compare(0, _path.length(), _path))
+    /**
+     * @brief Decode `PropertiesChanged` signal.
+     *
+     * Invalidated properties are not used, so they are left unread.
+     */
+    static void decodeProperties(sdbusplus::message::message& m,
+                                 fields_t& fields)
+    {
+        const char* iface = nullptr;
+        sdbusplus::helper::MessageReader(m).read(SD_BUS_TYPE_STRING, iface);
+        ItemType::decodeFields(m, ItemType::schema, fields);
+    }
+
+    /**
+     * @brief DBus signal `PropertiesChanged` handler.
+     *
+     * Dispatches the signal of any object in the folder to its item.
+     */
+    void onPropertiesChanged(sdbusplus::message::message& m)
+    {
+        ++_stats->signals;
+        auto item = findItem(m.get_path());
+        if (!item)
         {
-            bool isOwned = _interfaces.empty();
-            if (!isOwned)
+            ++_stats->ignored;
+        }
+        else
+        {
+            fields_t fields;
+            try
+            {
+                decodeProperties(m, fields);
+                ++_stats->decoded;
+            }
+            catch (const sdbusplus::exception::SdBusError& e)
             {
-                auto it =
-                    std::find_first_of(_interfaces.begin(), _interfaces.end(),
-                                       data.begin(), data.end());
-                isOwned = (it != _interfaces.end());
+                TRACE_ERROR("data/table: Failed to parse signal data. "
+                            "ERROR='%s', PATH='%s', MEMBER='%s'\n",
+                            e.what(), m.get_path(), m.get_member());
             }
+            // Values read before the error are kept like the valid ones.
+            item->setFields(fields);
+        }
+    }
+
+    /**
+     * @brief Decode `PropertiesChanged` signal on the ingestion thread.
+     *
+     * The changes are merged into the batch not applied yet, so repeated
+     * updates of an item are applied once. The items are not touched.
+     *
+     * @return false if the message is malformed.
+     */
+    bool ingest(sdbusplus::message::message& m)
+    {
+        std::string_view path = m.get_path();
+        if (path.length() <= _path.length() + 1 ||
+            0 != path.compare(0, _path.length(), _path) ||
+            path[_path.length()] != '/')
+        {
+            return true;
+        }
+        ++_stats->signals;
+
+        // Take the batch back from the main thread while it's filled.
+        auto batch = std::atomic_exchange(&_ingested, std::shared_ptr<Batch>());
+        if (!batch)
+        {
+            batch = std::make_shared<Batch>();
+        }
+
+        bool valid = true;
+        fields_t fields;
+        try
+        {
+            decodeProperties(m, fields);
+            ++_stats->decoded;
+        }
+        catch (const sdbusplus::exception::SdBusError&)
+        {
+            valid = false;
+        }
+        // The batch outlives the message, so the strings are copied.
+        (*batch)[std::string(path.substr(_path.length() + 1))].merge(fields);
+
+        std::atomic_store(&_ingested, std::move(batch));
+        return valid;
+    }
+
+    /**
+     * @brief Apply the changes decoded by the ingestion thread.
+     */
+    void applyIngested()
+    {
+        auto batch = std::atomic_exchange(&_ingested, std::shared_ptr<Batch>());
+        if (!batch)
+        {
+            return;
+        }
 
-            if (isOwned)
+        for (const auto& [name, fields] : *batch)
+        {
+            auto it = _index.find(name);
+            if (it != _index.end())
+            {
+                it->second->setFields(fields);
+            }
+            else
             {
-                dropItem(path.str);
+                ++_stats->ignored;
             }
         }
     }
 
+    /**
+     * @brief Find existing item by DBus object path.
+     *
+     * @return Pointer to the item or nullptr if not found.
+     */
+    ItemType* findItem(std::string_view path) const
+    {
+        // Skip folder and following '/'
+        if (path.length() <= _path.length() + 1 ||
+            0 != path.compare(0, _path.length(), _path) ||
+            path[_path.length()] != '/')
+        {
+            return nullptr;
+        }
+
+        auto it = _index.find(path.substr(_path.length() + 1));
+        return it != _index.end() ? it->second : nullptr;
+    }
+
     /**
      * @brief Create new item if does not exist and return reference.
      */
     ItemType& getItem(const std::string& path)
     {
-        auto name = path.substr(_path.length() + 1); // Skip following '/'
-        auto it = std::lower_bound(_items.begin(), _items.end(), name);
-        if (it != _items.end() && (*it)->name == name)
+        auto item = findItem(path);
+        if (item)
         {
-            return *(*it);
+            return *item;
         }
 
+        auto name = path.substr(_path.length() + 1); // Skip following '/'
+        auto it = std::lower_bound(_items.begin(), _items.end(), name);
         it = _items.emplace(it, std::make_unique<ItemType>(_path, name));
+        _index.emplace((*it)->name, it->get());
+        _stats->rows = _items.size();
         (*it)->onCreate();
         return *(*it);
     }
@@ -253,7 +1017,9 @@ template <typename ItemType> class Table
         if (it != _items.end())
         {
             (*it)->onDestroy();
+            _index.erase((*it)->name);
             it = _items.erase(it);
+            _stats->rows = _items.size();
         }
         return it;
     }
@@ -272,38 +1038,102 @@ template <typename ItemType> class Table
     }
 
     /**
-     * @brief Iterator hook routines
+     * @brief Compare item index with the OID suffix.
+     *
+     * OCTET STRING index is encoded as length followed by the bytes.
+     *
+     * @param name - Item name
+     * @param idx - Index OID
+     * @param len - Index OID length
+     *
+     * @return Negative, zero or positive value if the item index is less,
+     *         equal or greater than the OID.
      */
-    static netsnmp_variable_list*
-        get_first_data_point(void** loop_ctx, void** data_ctx,
-                             netsnmp_variable_list* idx_data,
-                             netsnmp_iterator_info* data)
+    static int compareIndex(const std::string& name, const oid* idx,
+                            size_t len)
     {
-        *loop_ctx = reinterpret_cast<void*>(0);
-        return Table<ItemType>::get_next_data_point(loop_ctx, data_ctx,
-                                                    idx_data, data);
+        if (0 == len)
+        {
+            return 1;
+        }
+        if (name.length() != idx[0])
+        {
+            return name.length() < idx[0] ? -1 : 1;
+        }
+        for (size_t i = 0; i < name.length(); ++i)
+        {
+            if (i + 1 >= len)
+            {
+                return 1;
+            }
+            oid c = static_cast<unsigned char>(name[i]);
+            if (c != idx[i + 1])
+            {
+                return c < idx[i + 1] ? -1 : 1;
+            }
+        }
+        return len > name.length() + 1 ? -1 : 0;
     }
-    static netsnmp_variable_list*
-        get_next_data_point(void** loop_ctx, void** data_ctx,
-                            netsnmp_variable_list* idx_data,
-                            netsnmp_iterator_info* data)
-    {
-        auto index = reinterpret_cast<size_t>(*loop_ctx);
-        auto& table = *reinterpret_cast<Table<ItemType>*>(data->myvoid);
 
-        if (index < table._items.size())
+    /**
+     * @brief Find the item for GET request.
+     */
+    ItemType* findIndex(const netsnmp_variable_list* index) const
+    {
+        if (!index || index->type != ASN_OCTET_STR || !index->val.string)
         {
-            auto& item = table._items[index];
+            return nullptr;
+        }
 
-            snmp_set_var_value(idx_data, item->name.c_str(),
-                               item->name.length());
+        auto it = _index.find(std::string_view(
+            reinterpret_cast<const char*>(index->val.string), index->val_len));
+        return it != _index.end() ? it->second : nullptr;
+    }
 
-            *data_ctx = item.get();
-            *loop_ctx = reinterpret_cast<void*>(index + 1);
-            return idx_data;
+    /**
+     * @brief Find the first item with index following the OID.
+     *
+     * Items are kept in order of their indexes, so the successor
+     * is found with binary search.
+     *
+     * @param idx - Index OID
+     * @param len - Index OID length
+     * @param include - Accept the item with index equal to the OID
+     */
+    typename Items::const_iterator lowerBound(const oid* idx, size_t len,
+                                              bool include) const
+    {
+        return std::partition_point(
+            _items.begin(), _items.end(),
+            [idx, len, include](const ItemPtr& item) {
+                int cmp = compareIndex(item->name, idx, len);
+                return include ? cmp < 0 : cmp <= 0;
+            });
+    }
+
+    /**
+     * @brief Find the item for GETNEXT request.
+     *
+     * The column is advanced past the last row.
+     *
+     * @param tinfo - Table request info, `colnum` is updated
+     *
+     * @return Pointer to the item or nullptr if the table is over.
+     */
+    ItemType* findNext(netsnmp_table_request_info* tinfo) const
+    {
+        auto it = lowerBound(tinfo->index_oid, tinfo->index_oid_len, false);
+
+        if (it == _items.end())
+        {
+            if (++tinfo->colnum > tinfo->reg_info->max_column)
+            {
+                return nullptr;
+            }
+            it = _items.begin();
         }
 
-        return nullptr;
+        return it != _items.end() ? it->get() : nullptr;
     }
 
     /**
@@ -314,14 +1144,30 @@ template <typename ItemType> class Table
                             netsnmp_agent_request_info* reqinfo,
                             netsnmp_request_info* requests)
     {
-        switch (reqinfo->mode)
+        auto& table = *reinterpret_cast<Table<ItemType>*>(handler->myvoid);
+        auto start = agent::ObjectStats::clock_t::now();
+        size_t variables = 0;
+
+        for (auto request = requests; request; request = request->next)
         {
-            case MODE_GET:
-                for (auto request = requests; request; request = request->next)
-                {
-                    auto entry = reinterpret_cast<ItemType*>(
-                        netsnmp_extract_iterator_context(request));
+            if (request->processed)
+            {
+                continue;
+            }
+
+            netsnmp_table_request_info* tinfo =
+                netsnmp_extract_table_info(request);
+            if (!tinfo)
+            {
+                continue;
+            }
 
+            switch (reqinfo->mode)
+            {
+                case MODE_GET:
+                {
+                    ++variables;
+                    auto entry = table.findIndex(tinfo->indexes);
                     if (!entry)
                     {
                         netsnmp_set_request_error(reqinfo, request,
@@ -329,18 +1175,68 @@ template <typename ItemType> class Table
                         continue;
                     }
 
-                    entry->get_snmp_reply(reqinfo, request);
+                    if (!entry->get_value(tinfo->colnum, request->requestvb))
+                    {
+                        netsnmp_set_request_error(reqinfo, request,
+                                                  SNMP_NOSUCHOBJECT);
+                    }
                 }
                 break;
+
+                case MODE_GETNEXT:
+                {
+                    // Leave request unanswered at the end of table,
+                    // the agent continues with the next subtree.
+                    auto entry = table.findNext(tinfo);
+                    if (entry)
+                    {
+                        ++variables;
+                        snmp_set_var_value(tinfo->indexes, entry->name.c_str(),
+                                           entry->name.length());
+                        netsnmp_table_build_oid(reginfo, request, tinfo);
+                        if (!entry->get_value(tinfo->colnum,
+                                              request->requestvb))
+                        {
+                            netsnmp_set_request_error(reqinfo, request,
+                                                      SNMP_NOSUCHOBJECT);
+                        }
+                    }
+                }
+                break;
+            }
         }
 
+        // Only the requests answered by the table are counted.
+        if (variables > 0)
+        {
+            table._stats->served(MODE_GET == reqinfo->mode
+                                     ? agent::ObjectStats::GET
+                                     : agent::ObjectStats::GETNEXT,
+                                 start, variables);
+        }
         return SNMP_ERR_NOERROR;
     }
 
     std::string _path;
     interfaces_t _interfaces;
+    std::optional<Dispatcher::Subscription> _subscription;
     std::vector<sdbusplus::bus::match::match> _matches;
+    // Published by the ingestion thread, taken by the main one.
+    std::shared_ptr<Batch> _ingested;
+    agent::ObjectStats* _stats = &agent::Stats::instance().add();
+    size_t _minColumn = 0;
+    size_t _maxColumn = 0;
     Items _items;
+    // Items index by name, the keys refer to `name` of items.
+    std::unordered_map<std::string_view, ItemType*> _index;
+
+    // Population state
+    Objects _subtree;
+    std::deque<Request> _queue;
+    std::list<sdbusplus::helper::AsyncCall> _calls;
+    size_t _inflight = 0;
+    bool _populating = false;
+    Population::clock_t::time_point _since;
 };
 
 } // namespace data
@@ -21,6 +21,17 @@
 #pragma once
 
 #include "sdbusplus/helper.hpp"
+#include "data/table/schema.hpp"
+#include "scheduler.hpp"
+
+#include <array>
+#include <bitset>
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
 
 namespace phosphor
 {
@@ -36,33 +47,78 @@ namespace table
  */
 template <typename... T> struct Item
 {
-    /*
-     * The `std::variant` allows to keep duplicates of types,
-     * but `std::get<>()` and `std::holds_alternative<>()` is ill-formed
-     * in this case.
+    using values_t = std::tuple<T...>;
+    using schema_t = Schema<sizeof...(T)>;
+
+    /**
+     * @brief Field values decoded from DBus properties.
      *
-     * So we can't use here:
-     *   using variant_t = std::variant<T...>;
-     * and we should specify all possible types.
+     * Strings refer to the message they are decoded from, see `merge()`
+     * to keep them longer.
      */
-    using variant_t = std::variant<int64_t, std::string, bool, uint8_t, double>;
+    struct fields_t
+    {
+        std::tuple<typename Decoded<T>::type...> values;
+        // Fields present in `values`
+        std::bitset<sizeof...(T)> mask;
+        // DBus strings for the fields of other types,
+        // see `setFieldString()`.
+        std::array<std::string_view, sizeof...(T)> strings;
+        // Fields present in `strings`
+        std::bitset<sizeof...(T)> converted;
+        // Copies of the strings merged from other fields.
+        std::list<std::string> storage;
 
-    using values_t = std::tuple<T...>;
-    using fields_map_t = std::map<std::string, variant_t>;
+        /**
+         * @brief Replace the fields present in `other`.
+         *
+         * Strings are copied, so the result outlives the message
+         * `other` is decoded from.
+         */
+        void merge(const fields_t& other)
+        {
+            merge(other, std::index_sequence_for<T...>{});
+        }
+
+      private:
+        template <size_t... Index>
+        void merge(const fields_t& other, std::index_sequence<Index...>)
+        {
+            ((other.mask.test(Index)
+                  ? void((std::get<Index>(values) =
+                              keep(std::get<Index>(other.values)),
+                          mask.set(Index), converted.reset(Index)))
+                  : other.converted.test(Index)
+                        ? void((strings[Index] = keep(other.strings[Index]),
+                                converted.set(Index), mask.reset(Index)))
+                        : void()),
+             ...);
+        }
+
+        template <typename V> static const V& keep(const V& value)
+        {
+            return value;
+        }
+
+        std::string_view keep(std::string_view value)
+        {
+            return storage.emplace_back(value);
+        }
+    };
 
     /* Define all of the basic class operations:
      *     Not allowed:
      *         - Default constructor to avoid nullptrs.
-     *         - Copy operations due to internal unique_ptr.
+     *         - Copy and move operations due to the timer refers
+     *           to the item.
      *     Allowed:
-     *         - Move operations.
      *         - Destructor.
      */
     Item() = delete;
     Item(const Item&) = delete;
     Item& operator=(const Item&) = delete;
-    Item(Item&&) = default;
-    Item& operator=(Item&&) = default;
+    Item(Item&&) = delete;
+    Item& operator=(Item&&) = delete;
     ~Item() = default;
 
     /**
@@ -72,83 +128,240 @@ template <typename... T> struct Item
      * @param name - DBus object path relative by folder
      * @param args - Default values for each fields
      */
-    Item(const std::string& folder, const std::string& name, T&&... args) :
-        name(name), data(std::forward<T>(args)...),
-        changedMatch(sdbusplus::helper::helper::getBus(),
-                     sdbusplus::bus::match::rules::propertiesChanged(
-                         folder + "/" + name),
-                     std::bind(&Item<T...>::onPropertiesChanged, this,
-                               std::placeholders::_1))
+    Item(const std::string& /*folder*/, const std::string& name,
+         T&&... args) :
+        name(name),
+        data(std::forward<T>(args)...)
     {
     }
 
     /**
-     * @brief PropertiesChanged signal handler
+     * @brief Store fields values recieved from DBus
+     *
+     * @param fields - Decoded values, see `decodeFields()`.
+     */
+    virtual void setFields(const fields_t& fields) = 0;
+
+    /**
+     * @brief Called after object has been created.
      */
-    virtual void onPropertiesChanged(sdbusplus::message::message& m)
+    virtual void onCreate()
     {
-        std::string iface;
-        fields_map_t data;
-        std::vector<std::string> v;
-        m.read(iface, data, v);
+    }
 
-        setFields(data);
+    /**
+     * @brief Called before object will be destroyed.
+     */
+    virtual void onDestroy()
+    {
     }
 
     /**
-     * @brief Store fields values recieved from DBus
+     * @brief Called when the time scheduled by `schedule()` is over.
      */
-    virtual void setFields(const fields_map_t& fields) = 0;
+    virtual void onTimer()
+    {
+    }
 
     /**
-     * @brief Called after object has been created.
+     * @brief Call `onTimer()` after the timeout.
+     *
+     * Replaces the previously scheduled call. The timer is shared
+     * by all items, see `agent::Scheduler`.
      */
-    virtual void onCreate()
+    void schedule(agent::Scheduler::clock_t::duration timeout)
     {
+        if (!_timer)
+        {
+            _timer = std::make_unique<agent::Timer>([this]() { onTimer(); });
+        }
+        _timer->start(timeout);
     }
 
     /**
-     * @brief Called before object will be destroyed.
+     * @brief Cancel the scheduled call of `onTimer()`.
      */
-    virtual void onDestroy()
+    void cancel()
     {
+        if (_timer)
+        {
+            _timer->stop();
+        }
     }
 
     /**
-     * @brief String fields vlaues helper
+     * @brief Check if the call of `onTimer()` is scheduled.
      */
-    template <size_t Index>
-    void setField(const fields_map_t& fieldsMap, const char* propertyName)
+    bool scheduled() const
+    {
+        return _timer && _timer->running();
+    }
+
+    /**
+     * @brief Decode properties dictionary.
+     *
+     * Properties are streamed from the message without touching any item,
+     * so the decoding may run outside of the main loop. Unknown properties
+     * and values of unexpected types are skipped. Values already present
+     * in `fields` are replaced, so several messages may be merged into
+     * a single update.
+     *
+     * @param m - Message positioned at the `a{sv}` properties dictionary.
+     * @param schema - DBus property names of the fields
+     * @param fields - Decoded values
+     */
+    static void decodeFields(sdbusplus::message::message& m,
+                             const schema_t& schema, fields_t& fields)
+    {
+        sdbusplus::helper::MessageReader reader(m);
+
+        reader.enter(SD_BUS_TYPE_ARRAY, "{sv}");
+        while (reader.enter(SD_BUS_TYPE_DICT_ENTRY, "sv"))
+        {
+            const char* property = nullptr;
+            reader.read(SD_BUS_TYPE_STRING, property);
+
+            auto index = schema.find(property);
+            if (index == schema_t::npos ||
+                !decodeField(reader, index, fields,
+                             std::index_sequence_for<T...>{}))
+            {
+                reader.skip("v");
+            }
+            reader.exit();
+        }
+        reader.exit();
+    }
+
+    /**
+     * @brief Store decoded values into fields.
+     *
+     * @param fields - Values decoded by `decodeFields()`
+     */
+    void readFields(const fields_t& fields)
     {
-        using FieldType = typename std::tuple_element<Index, values_t>::type;
-        if (fieldsMap.find(propertyName) != fieldsMap.end() &&
-            std::holds_alternative<FieldType>(fieldsMap.at(propertyName)))
+        readFields(fields, std::index_sequence_for<T...>{});
+        for (size_t index = 0; index < sizeof...(T); ++index)
         {
-            std::get<Index>(data) =
-                std::get<FieldType>(fieldsMap.at(propertyName));
+            // The field just stays unchanged if conversion
+            // is not supported.
+            if (fields.converted.test(index))
+            {
+                setFieldString(index, fields.strings[index]);
+            }
         }
     }
 
     /**
-     * @brief Fill snmp reply with fields values
+     * @brief Set field from DBus string of other type than field has.
+     *
+     * Override to convert DBus enumerations.
+     *
+     * @param index - Field index
+     * @param value - DBus string value
+     *
+     * @return false if the field doesn't support conversion.
+     */
+    virtual bool setFieldString(size_t /*index*/, std::string_view /*value*/)
+    {
+        return false;
+    }
+
+    /**
+     * @brief Fill the variable with the column value.
+     *
+     * @param column - Column number
+     * @param var - Variable to fill
+     *
+     * @return false if the column is not supported.
      */
-    virtual void get_snmp_reply(netsnmp_agent_request_info* reqinfo,
-                                netsnmp_request_info* request) const = 0;
+    virtual bool get_value(int column, netsnmp_variable_list* var) const = 0;
 
     std::string name;
     values_t data;
 
   private:
-    sdbusplus::bus::match::match changedMatch;
+    /**
+     * @brief Decode variant value of field specified by runtime index.
+     *
+     * @return false if value has not been read.
+     */
+    template <size_t... Index>
+    static bool decodeField(sdbusplus::helper::MessageReader& reader,
+                            size_t index, fields_t& fields,
+                            std::index_sequence<Index...>)
+    {
+        bool done = false;
+        ((Index == index &&
+          (done = decodeField<Index>(reader, fields), true)) ||
+         ...);
+        return done;
+    }
+
+    template <size_t Index>
+    static bool decodeField(sdbusplus::helper::MessageReader& reader,
+                            fields_t& fields)
+    {
+        using FieldType = std::tuple_element_t<Index, values_t>;
+        using signature_t = Signature<FieldType>;
+
+        const char* contents = reader.peekVariant();
+        if (!contents || contents[0] == '\0' || contents[1] != '\0')
+        {
+            return false;
+        }
+
+        if (contents[0] == signature_t::type)
+        {
+            typename signature_t::dbus_t value{};
+            reader.enter(SD_BUS_TYPE_VARIANT, contents);
+            reader.read(signature_t::type, value);
+            reader.exit();
+            std::get<Index>(fields.values) = value;
+            fields.mask.set(Index);
+            fields.converted.reset(Index);
+            return true;
+        }
+
+        if (contents[0] == SD_BUS_TYPE_STRING)
+        {
+            const char* value = nullptr;
+            reader.enter(SD_BUS_TYPE_VARIANT, contents);
+            reader.read(SD_BUS_TYPE_STRING, value);
+            reader.exit();
+            fields.strings[Index] = value;
+            fields.converted.set(Index);
+            fields.mask.reset(Index);
+            return true;
+        }
+
+        return false;
+    }
+
+    template <size_t... Index>
+    void readFields(const fields_t& fields, std::index_sequence<Index...>)
+    {
+        ((fields.mask.test(Index)
+              ? void(std::get<Index>(data) = std::get<Index>(fields.values))
+              : void()),
+         ...);
+    }
+
+    // Created on the first `schedule()`, most items never need it.
+    std::unique_ptr<agent::Timer> _timer;
 };
 
 /**
  * @brief Used for std::lower_bound throw vector of smartpointers.
+ *
+ * Items are ordered like their indexes in MIB: OCTET STRING index
+ * is encoded as length followed by the bytes.
  */
 template <typename ItemType>
 inline bool operator<(const std::unique_ptr<ItemType>& o, const std::string& s)
 {
-    return o->name < s;
+    return o->name.length() < s.length() ||
+           (o->name.length() == s.length() && o->name < s);
 }
 
 } // namespace table
@@ -0,0 +1,230 @@
+/**
+ * @brief Compile-time map of DBus properties to MIB table item fields.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace data
+{
+namespace table
+{
+
+/**
+ * @brief DBus property names of the item fields.
+ *
+ * The names are placed into a perfect hash table at compile time,
+ * so lookup costs one hash and one string comparison.
+ *
+ * @tparam N - Number of fields
+ */
+template <size_t N> class Schema
+{
+  public:
+    /** @brief Returned by `find()` for unknown names. */
+    static constexpr size_t npos = N;
+
+    /**
+     * @brief Build the hash table.
+     *
+     * @param names - DBus property name for each field,
+     *                empty name means the field is not fetched from DBus.
+     */
+    constexpr explicit Schema(const std::array<std::string_view, N>& names) :
+        _names(names)
+    {
+        for (uint32_t seed = 0; seed < maxSeed; ++seed)
+        {
+            if (build(seed))
+            {
+                _seed = seed;
+                return;
+            }
+        }
+        throw std::logic_error("Schema: duplicate property names");
+    }
+
+    /**
+     * @brief Get index of the field by property name.
+     *
+     * @return Field index or `npos` if not found.
+     */
+    constexpr size_t find(std::string_view name) const
+    {
+        auto index = _slots[hash(name, _seed) & (slotsCount - 1)];
+        return index != npos && _names[index] == name ? index : npos;
+    }
+
+  private:
+    static constexpr uint32_t maxSeed = 0x1000;
+
+    static constexpr size_t ceilPow2(size_t n)
+    {
+        size_t p = 1;
+        while (p < n)
+        {
+            p <<= 1;
+        }
+        return p;
+    }
+
+    // Twice more slots than fields keep the seed search short.
+    static constexpr size_t slotsCount = ceilPow2(N * 2);
+
+    /**
+     * @brief Seeded FNV-1a.
+     *
+     * Multiplication spreads changes only to the upper bits,
+     * so the final mix is required to use the lower ones as slot index.
+     */
+    static constexpr uint32_t hash(std::string_view s, uint32_t seed)
+    {
+        uint32_t h = 2166136261u ^ seed;
+        for (auto c : s)
+        {
+            h ^= static_cast<uint8_t>(c);
+            h *= 16777619u;
+        }
+        h ^= h >> 16;
+        h *= 0x7feb352du;
+        h ^= h >> 15;
+        return h;
+    }
+
+    constexpr bool build(uint32_t seed)
+    {
+        for (auto& slot : _slots)
+        {
+            slot = npos;
+        }
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (_names[i].empty())
+            {
+                continue;
+            }
+            auto& slot = _slots[hash(_names[i], seed) & (slotsCount - 1)];
+            if (slot != npos)
+            {
+                return false;
+            }
+            slot = i;
+        }
+        return true;
+    }
+
+    std::array<std::string_view, N> _names;
+    std::array<size_t, slotsCount> _slots{};
+    uint32_t _seed = 0;
+};
+
+/**
+ * @brief Make schema from the list of DBus property names.
+ *
+ * Names should be listed in order of the item fields.
+ */
+template <typename... Names> constexpr auto makeSchema(Names... names)
+{
+    return Schema<sizeof...(Names)>({std::string_view(names)...});
+}
+
+/**
+ * @brief DBus signature of the field type.
+ */
+template <typename T> struct Signature;
+
+template <> struct Signature<bool>
+{
+    static constexpr char type = 'b';
+    using dbus_t = int; // sd-bus reads booleans as int
+};
+template <> struct Signature<uint8_t>
+{
+    static constexpr char type = 'y';
+    using dbus_t = uint8_t;
+};
+template <> struct Signature<int16_t>
+{
+    static constexpr char type = 'n';
+    using dbus_t = int16_t;
+};
+template <> struct Signature<uint16_t>
+{
+    static constexpr char type = 'q';
+    using dbus_t = uint16_t;
+};
+template <> struct Signature<int32_t>
+{
+    static constexpr char type = 'i';
+    using dbus_t = int32_t;
+};
+template <> struct Signature<uint32_t>
+{
+    static constexpr char type = 'u';
+    using dbus_t = uint32_t;
+};
+template <> struct Signature<int64_t>
+{
+    static constexpr char type = 'x';
+    using dbus_t = int64_t;
+};
+template <> struct Signature<uint64_t>
+{
+    static constexpr char type = 't';
+    using dbus_t = uint64_t;
+};
+template <> struct Signature<double>
+{
+    static constexpr char type = 'd';
+    using dbus_t = double;
+};
+template <> struct Signature<std::string>
+{
+    static constexpr char type = 's';
+    using dbus_t = const char*;
+};
+
+/**
+ * @brief Type of the field value decoded from DBus message.
+ *
+ * Strings are viewed in the message, they are copied only by
+ * the assignment to the field.
+ */
+template <typename T> struct Decoded
+{
+    using type = T;
+};
+template <> struct Decoded<std::string>
+{
+    using type = std::string_view;
+};
+
+} // namespace table
+} // namespace data
+} // namespace snmp
+} // namespace phosphor
@@ -0,0 +1,141 @@
+/**
+ * @brief Histogram of durations.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+/**
+ * @brief Histogram of durations with power of two buckets.
+ *
+ * The first bucket counts durations below 8 us, every next one
+ * doubles the upper bound, the last one has no bound. Adding a sample
+ * costs a few instructions, so it is fine for every request.
+ */
+class Histogram
+{
+  public:
+    using duration_t = std::chrono::microseconds;
+
+    static constexpr size_t buckets = 20;
+
+    /**
+     * @brief Upper bound of the bucket, the last one has none.
+     */
+    static constexpr duration_t bound(size_t bucket)
+    {
+        return duration_t(uint64_t(8) << bucket);
+    }
+
+    /**
+     * @brief Count the sample.
+     */
+    template <typename Rep, typename Period>
+    void add(std::chrono::duration<Rep, Period> sample)
+    {
+        auto us = std::chrono::duration_cast<duration_t>(sample).count();
+        uint64_t value = us > 0 ? static_cast<uint64_t>(us) : 0;
+
+        size_t bucket = 0;
+        if (value >> 3)
+        {
+            bucket = 64 - __builtin_clzll(value >> 3);
+        }
+        ++_counts[bucket < buckets ? bucket : buckets - 1];
+        ++_count;
+        _total += value;
+        if (value > _max)
+        {
+            _max = value;
+        }
+    }
+
+    /** @brief Number of samples in the bucket. */
+    uint64_t count(size_t bucket) const
+    {
+        return _counts[bucket];
+    }
+
+    /** @brief Number of samples. */
+    uint64_t count() const
+    {
+        return _count;
+    }
+
+    /** @brief Sum of samples. */
+    duration_t total() const
+    {
+        return duration_t(_total);
+    }
+
+    /** @brief Longest sample. */
+    duration_t max() const
+    {
+        return duration_t(_max);
+    }
+
+    /** @brief Average sample. */
+    duration_t average() const
+    {
+        return duration_t(_count ? _total / _count : 0);
+    }
+
+    /**
+     * @brief Upper bound of the bucket where the percentile falls.
+     *
+     * The longest sample is returned if it falls into the last bucket.
+     *
+     * @param percent - Percentile, 0 to 100
+     */
+    duration_t percentile(double percent) const
+    {
+        auto rank = static_cast<uint64_t>(_count * percent / 100.);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < buckets - 1; ++i)
+        {
+            seen += _counts[i];
+            if (seen > rank)
+            {
+                return std::min(bound(i), max());
+            }
+        }
+        return max();
+    }
+
+  private:
+    std::array<uint64_t, buckets> _counts{};
+    uint64_t _count = 0;
+    uint64_t _total = 0;
+    uint64_t _max = 0;
+};
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
@@ -0,0 +1,312 @@
+/**
+ * @brief SNMP informs delivery implementation.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "tracing.hpp"
+#include "informsender.hpp"
+#include "snmp.hpp"
+
+#include <algorithm>
+#include <optional>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+// sysUpTime.0, the first variable of SNMPv2 notification
+static const oid sysUpTimeOid[] = {1, 3, 6, 1, 2, 1, 1, 3, 0};
+
+InformSender::Inform::Inform(const std::string& rowKey,
+                             const details::SharedVariableList& vars) :
+    rowKey(rowKey),
+    vars(vars), queued(clock_t::now())
+{
+}
+
+InformSender& InformSender::instance()
+{
+    static InformSender sender;
+    return sender;
+}
+
+void InformSender::init()
+{
+    for (const auto& target : targets)
+    {
+        auto& destination = _destinations.emplace_back(*this, target);
+
+        netsnmp_session session;
+        snmp_sess_init(&session);
+        session.version = SNMP_VERSION_2c;
+        session.peername = const_cast<char*>(destination.target.peer.c_str());
+        session.community = reinterpret_cast<u_char*>(
+            const_cast<char*>(destination.target.community.c_str()));
+        session.community_len = destination.target.community.size();
+        // Retransmissions are done by the sender with backoff.
+        session.retries = 0;
+        session.timeout =
+            std::chrono::duration_cast<std::chrono::microseconds>(timeout)
+                .count();
+
+        destination.session = snmp_open(&session);
+        if (!destination.session)
+        {
+            TRACE_ERROR("Can't open inform session to %s: %s\n",
+                        target.peer.c_str(),
+                        snmp_api_errstring(session.s_snmp_errno));
+            _destinations.pop_back();
+            continue;
+        }
+
+        TRACE_INFO("Informs are sent to %s\n", target.peer.c_str());
+    }
+}
+
+void InformSender::destroy()
+{
+    for (auto& destination : _destinations)
+    {
+        destination.waiting.clear();
+        destination.informs.clear();
+        destination.inflight = 0;
+        snmp_close(destination.session);
+    }
+    _destinations.clear();
+
+    DEBUGMSGTL(("snmpagent:inform",
+                "submitted=%llu, acknowledged=%llu, retransmitted=%llu, "
+                "failed=%llu, superseded=%llu, overflowed=%llu, "
+                "latency avg=%lld ms, max=%lld ms\n",
+                static_cast<unsigned long long>(submitted()),
+                static_cast<unsigned long long>(acknowledged()),
+                static_cast<unsigned long long>(retransmitted()),
+                static_cast<unsigned long long>(failed()),
+                static_cast<unsigned long long>(coalesced()),
+                static_cast<unsigned long long>(overflowed()),
+                static_cast<long long>(averageLatency().count()),
+                static_cast<long long>(maxLatency().count())));
+}
+
+void InformSender::submit(const details::SharedVariableList& vars,
+                          const std::string& rowKey)
+{
+    for (auto& destination : _destinations)
+    {
+        auto waiting = destination.waiting.find(rowKey);
+        if (waiting != destination.waiting.end())
+        {
+            // Only the latest state of the row is worth delivering.
+            ++_coalesced;
+            destination.drop(waiting->second);
+        }
+
+        if (destination.informs.size() >= queueSize)
+        {
+            ++_overflowed;
+            auto oldest = std::find_if(
+                destination.informs.begin(), destination.informs.end(),
+                [](const Inform& inform) { return 0 == inform.reqid; });
+            if (oldest == destination.informs.end())
+            {
+                DEBUGMSGTL(("snmpagent:inform",
+                            "Inform to %s dropped: queue is full\n",
+                            destination.target.peer.c_str()));
+                continue;
+            }
+            DEBUGMSGTL(("snmpagent:inform",
+                        "Oldest inform to %s dropped: queue is full\n",
+                        destination.target.peer.c_str()));
+            destination.drop(oldest);
+        }
+
+        destination.informs.emplace_back(rowKey, vars);
+        destination.waiting.emplace(rowKey,
+                                    std::prev(destination.informs.end()));
+        ++_submitted;
+        destination.pump();
+    }
+}
+
+void InformSender::Destination::pump()
+{
+    auto now = clock_t::now();
+    for (auto it = informs.begin();
+         it != informs.end() && inflight < outstanding;)
+    {
+        auto current = it++;
+        if (current->reqid || current->retryAt > now)
+        {
+            continue;
+        }
+
+        waiting.erase(current->rowKey);
+        if (!send(current))
+        {
+            retry(current);
+        }
+    }
+    schedule();
+}
+
+void InformSender::Destination::schedule()
+{
+    auto now = clock_t::now();
+    std::optional<clock_t::time_point> next;
+    for (const auto& inform : informs)
+    {
+        if (!inform.reqid && inform.retryAt > now &&
+            (!next || inform.retryAt < *next))
+        {
+            next = inform.retryAt;
+        }
+    }
+
+    if (next)
+    {
+        // Rounded up, so the timer doesn't expire before the time.
+        backoff.start(
+            std::chrono::ceil<Scheduler::clock_t::duration>(*next - now));
+    }
+    else
+    {
+        backoff.stop();
+    }
+}
+
+bool InformSender::Destination::send(Informs::iterator it)
+{
+    auto pdu = snmp_pdu_create(SNMP_MSG_INFORM);
+    if (!pdu)
+    {
+        return false;
+    }
+
+    u_long uptime = netsnmp_get_agent_uptime();
+    snmp_pdu_add_variable(pdu, sysUpTimeOid, OID_LENGTH(sysUpTimeOid),
+                          ASN_TIMETICKS, &uptime, sizeof(uptime));
+    for (auto var = it->vars.get(); var; var = var->next_variable)
+    {
+        snmp_pdu_add_variable(pdu, var->name, var->name_length, var->type,
+                              var->val.string, var->val_len);
+    }
+
+    if (++it->attempts > 1)
+    {
+        ++sender._retransmitted;
+    }
+
+    auto reqid = snmp_async_send(session, pdu, onResponse, this);
+    if (0 == reqid)
+    {
+        DEBUGMSGTL(("snmpagent:inform", "Inform to %s not sent: %s\n",
+                    target.peer.c_str(),
+                    snmp_api_errstring(session->s_snmp_errno)));
+        snmp_free_pdu(pdu);
+        return false;
+    }
+
+    it->reqid = reqid;
+    ++inflight;
+    // The response timeout is served by the event loop.
+    snmpagent_update();
+    return true;
+}
+
+void InformSender::Destination::retry(Informs::iterator it)
+{
+    if (waiting.count(it->rowKey))
+    {
+        // The row has changed since, the newer inform replaces this one.
+        ++sender._coalesced;
+        informs.erase(it);
+        return;
+    }
+
+    if (it->attempts > retries)
+    {
+        ++sender._failed;
+        TRACE_WARNING("Inform to %s dropped: not acknowledged after "
+                      "%zu attempts\n",
+                      target.peer.c_str(), it->attempts);
+        informs.erase(it);
+        return;
+    }
+
+    auto delay = timeout;
+    for (size_t i = 1; i < it->attempts && delay < maxBackoff; ++i)
+    {
+        delay *= 2;
+    }
+    it->retryAt = clock_t::now() + std::min(delay, maxBackoff);
+    waiting.emplace(it->rowKey, it);
+}
+
+void InformSender::Destination::drop(Informs::iterator it)
+{
+    auto waiting = this->waiting.find(it->rowKey);
+    if (waiting != this->waiting.end() && waiting->second == it)
+    {
+        this->waiting.erase(waiting);
+    }
+    informs.erase(it);
+}
+
+int InformSender::Destination::onResponse(int op, netsnmp_session* /*session*/,
+                                          int reqid, netsnmp_pdu* /*pdu*/,
+                                          void* magic)
+{
+    auto destination = static_cast<Destination*>(magic);
+    auto& informs = destination->informs;
+    auto it = std::find_if(
+        informs.begin(), informs.end(),
+        [reqid](const Inform& inform) { return reqid == inform.reqid; });
+    if (it == informs.end())
+    {
+        return 1;
+    }
+
+    it->reqid = 0;
+    --destination->inflight;
+
+    if (NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE == op)
+    {
+        auto& sender = destination->sender;
+        auto latency = clock_t::now() - it->queued;
+        ++sender._acknowledged;
+        sender._latency += latency;
+        sender._maxLatency = std::max(sender._maxLatency, latency);
+        informs.erase(it);
+    }
+    else
+    {
+        DEBUGMSGTL(("snmpagent:inform", "Inform to %s not acknowledged\n",
+                    destination->target.peer.c_str()));
+        destination->retry(it);
+    }
+
+    destination->pump();
+    return 1;
+}
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
@@ -0,0 +1,265 @@
+/**
+ * @brief SNMP informs delivery.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+
+#include "scheduler.hpp"
+#include "snmpvars.hpp"
+
+#include <chrono>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+/**
+ * @brief Sender of notifications as SNMPv2c informs.
+ *
+ * The AgentX master decides itself how to deliver traps of the subagent,
+ * so informs are sent by own sessions to the configured targets.
+ * Each target has a bounded queue. A queued inform is replaced by the next
+ * one of the same row. Unacknowledged informs are retransmitted with
+ * exponential backoff until the retries are exhausted.
+ */
+class InformSender
+{
+  public:
+    using clock_t = std::chrono::steady_clock;
+
+    /**
+     * @brief Inform receiver.
+     */
+    struct Target
+    {
+        std::string peer;      // [transport:]host[:port]
+        std::string community; // SNMPv2c community
+    };
+
+    /**
+     * @brief Receivers of informs, no informs are sent if empty.
+     */
+    inline static std::vector<Target> targets;
+
+    /**
+     * @brief Time to wait for acknowledgement.
+     */
+    inline static std::chrono::milliseconds timeout{1000};
+
+    /**
+     * @brief Max delay before retransmission, doubled from `timeout`.
+     */
+    inline static std::chrono::milliseconds maxBackoff{60000};
+
+    /**
+     * @brief Number of retransmissions before the inform is dropped.
+     */
+    inline static size_t retries = 5;
+
+    /**
+     * @brief Max number of unacknowledged informs per target.
+     */
+    inline static size_t outstanding = 4;
+
+    /**
+     * @brief Max number of informs per target, including outstanding.
+     */
+    inline static size_t queueSize = 64;
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Copy and move operations due to singleton.
+     *     Allowed:
+     *         - Default constructor.
+     *         - Destructor.
+     */
+    InformSender() = default;
+    InformSender(const InformSender&) = delete;
+    InformSender& operator=(const InformSender&) = delete;
+    InformSender(InformSender&&) = delete;
+    InformSender& operator=(InformSender&&) = delete;
+    ~InformSender() = default;
+
+    /**
+     * @brief Process-wide sender.
+     */
+    static InformSender& instance();
+
+    /**
+     * @brief Open sessions to the configured targets.
+     */
+    void init();
+
+    /**
+     * @brief Close sessions and drop queued informs.
+     */
+    void destroy();
+
+    /**
+     * @brief Queue the notification for all targets.
+     *
+     * @param vars - Notification variables, starting with snmpTrapOID.0,
+     *               must not be changed while the sender holds them.
+     * @param rowKey - Key of the row for coalescing.
+     */
+    void submit(const details::SharedVariableList& vars,
+                const std::string& rowKey);
+
+    /** @brief Number of informs queued for all targets. */
+    uint64_t submitted() const
+    {
+        return _submitted;
+    }
+
+    /** @brief Number of acknowledged informs. */
+    uint64_t acknowledged() const
+    {
+        return _acknowledged;
+    }
+
+    /** @brief Number of retransmissions. */
+    uint64_t retransmitted() const
+    {
+        return _retransmitted;
+    }
+
+    /** @brief Number of informs dropped after all retries. */
+    uint64_t failed() const
+    {
+        return _failed;
+    }
+
+    /** @brief Number of queued informs replaced by later ones. */
+    uint64_t coalesced() const
+    {
+        return _coalesced;
+    }
+
+    /** @brief Number of informs dropped due to the queue overflow. */
+    uint64_t overflowed() const
+    {
+        return _overflowed;
+    }
+
+    /** @brief Average time from queueing to acknowledgement. */
+    std::chrono::milliseconds averageLatency() const
+    {
+        if (0 == _acknowledged)
+        {
+            return {};
+        }
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            _latency / static_cast<clock_t::rep>(_acknowledged));
+    }
+
+    /** @brief Max time from queueing to acknowledgement. */
+    std::chrono::milliseconds maxLatency() const
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            _maxLatency);
+    }
+
+  private:
+    struct Destination;
+
+    /**
+     * @brief Queued inform.
+     */
+    struct Inform
+    {
+        Inform(const std::string& rowKey,
+               const details::SharedVariableList& vars);
+
+        std::string rowKey;
+        details::SharedVariableList vars;
+        clock_t::time_point queued;
+        size_t attempts = 0;
+        int reqid = 0; // Non-zero while waiting for acknowledgement
+        // Not sent again before this time.
+        clock_t::time_point retryAt{};
+    };
+
+    using Informs = std::list<Inform>;
+
+    /**
+     * @brief Session and queue of the target.
+     */
+    struct Destination
+    {
+        Destination(InformSender& sender, const Target& target) :
+            sender(sender), target(target), backoff([this]() { pump(); })
+        {
+        }
+
+        /** @brief Send ready informs up to the outstanding limit. */
+        void pump();
+
+        /** @brief Start `backoff` for the earliest retransmission. */
+        void schedule();
+
+        /** @brief Send the inform, returns false on failure. */
+        bool send(Informs::iterator it);
+
+        /** @brief Unacknowledged inform, retransmit or drop it. */
+        void retry(Informs::iterator it);
+
+        /** @brief Drop the inform. */
+        void drop(Informs::iterator it);
+
+        /** @brief net-snmp response callback. */
+        static int onResponse(int op, netsnmp_session* session, int reqid,
+                              netsnmp_pdu* pdu, void* magic);
+
+        InformSender& sender;
+        Target target;
+        netsnmp_session* session = nullptr;
+        Informs informs;
+        // Informs not sent yet or waiting for retransmission by row.
+        std::unordered_map<std::string, Informs::iterator> waiting;
+        size_t inflight = 0;
+        // Calls `pump()` when a retransmission is due. A single timer per
+        // target, so the informs are free to go from its callback.
+        Timer backoff;
+    };
+
+    std::list<Destination> _destinations;
+
+    uint64_t _submitted = 0;
+    uint64_t _acknowledged = 0;
+    uint64_t _retransmitted = 0;
+    uint64_t _failed = 0;
+    uint64_t _coalesced = 0;
+    uint64_t _overflowed = 0;
+    clock_t::duration _latency{};
+    clock_t::duration _maxLatency{};
+};
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
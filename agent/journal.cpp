@@ -0,0 +1,405 @@
+/**
+ * @brief Persistent journal of the notifications implementation.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "tracing.hpp"
+#include "journal.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+static constexpr std::array<char, 8> MAGIC = {'Y', 'S', 'N', 'M',
+                                              'P', 'J', 'R', 'N'};
+static constexpr uint32_t VERSION = 2;
+
+// Encoded variable: type, number of arcs, value length, arcs, value.
+static constexpr size_t VARIABLE_HEADER = 4;
+
+Journal& Journal::instance()
+{
+    static Journal journal;
+    return journal;
+}
+
+void Journal::init()
+{
+    _capacity = capacity;
+    if (path.empty() || 0 == _capacity || !map())
+    {
+        return;
+    }
+
+    // Continue numbering after the last valid record, unless the journal
+    // is already used by another process.
+    uint32_t last = 0;
+    for (size_t i = 0; i < _capacity; ++i)
+    {
+        const auto& record = _records[i];
+        if (record.sequence % _capacity == i &&
+            valid(record, record.sequence))
+        {
+            last = std::max(last, record.sequence);
+        }
+    }
+    auto next = _header->next.load();
+    while (next <= last && !_header->next.compare_exchange_weak(next, last + 1))
+    {
+    }
+    last = this->last();
+    _settled = last;
+
+    if (flushInterval.count() > 0)
+    {
+        _flush = std::make_unique<Timer>([this]() { flush(); });
+    }
+
+    TRACE_INFO("Notification journal '%s', %zu records, last sequence %u\n",
+               path.c_str(), _capacity, last);
+}
+
+void Journal::destroy()
+{
+    if (!_base)
+    {
+        return;
+    }
+
+    flush();
+    _flush.reset();
+    DEBUGMSGTL(("snmpagent:journal", "written=%llu, flushed=%llu, last=%u\n",
+                static_cast<unsigned long long>(_written),
+                static_cast<unsigned long long>(_flushed), last()));
+    munmap(_base, _size);
+    _base = nullptr;
+    _header = nullptr;
+    _records = nullptr;
+    _size = 0;
+}
+
+uint32_t Journal::append(const netsnmp_variable_list* vars)
+{
+    if (!_records)
+    {
+        return 0;
+    }
+
+    auto sequence = _header->next.fetch_add(1);
+    if (0 == sequence)
+    {
+        // Wrapped around, 0 means empty record.
+        sequence = _header->next.fetch_add(1);
+    }
+
+    auto& record = slot(sequence);
+    record.time = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count();
+    encode(record, vars);
+    record.sequence = sequence;
+    record.checksum = checksum(record);
+
+    if (0 == _dirtyFirst)
+    {
+        _dirtyFirst = sequence;
+    }
+    _dirtyLast = sequence;
+    ++_written;
+
+    if (_flush && !_flush->running())
+    {
+        _flush->start(flushInterval);
+    }
+
+    return sequence;
+}
+
+const Journal::Record* Journal::find(uint32_t sequence) const
+{
+    if (!_records || 0 == sequence)
+    {
+        return nullptr;
+    }
+
+    const auto& record = slot(sequence);
+    return valid(record, sequence) ? &record : nullptr;
+}
+
+const Journal::Record* Journal::next(uint32_t sequence) const
+{
+    auto newest = last();
+    if (!_records || sequence >= newest)
+    {
+        return nullptr;
+    }
+
+    // Records older than the ring capacity are overwritten.
+    uint32_t oldest = newest >= _capacity ? newest - _capacity + 1 : 1;
+    for (auto i = std::max(sequence + 1, oldest); i <= newest; ++i)
+    {
+        if (auto record = find(i))
+        {
+            return record;
+        }
+        if (i > _settled && !lost(i))
+        {
+            return nullptr;
+        }
+    }
+    return nullptr;
+}
+
+bool Journal::lost(uint32_t sequence) const
+{
+    auto now = std::chrono::steady_clock::now();
+    if (_waiting != sequence)
+    {
+        _waiting = sequence;
+        _waitingSince = now;
+        return false;
+    }
+    return now - _waitingSince >= appendTimeout;
+}
+
+bool Journal::decode(const Record& record, size_t& offset, Variable& var)
+{
+    if (offset + VARIABLE_HEADER > record.length)
+    {
+        return false;
+    }
+
+    auto data = record.data.data() + offset;
+    uint16_t length;
+    memcpy(&length, data + 2, sizeof(length));
+    size_t arcs = data[1];
+    auto size = VARIABLE_HEADER + arcs * sizeof(uint32_t) + length;
+    if (offset + size > record.length)
+    {
+        return false;
+    }
+
+    var.type = data[0];
+    var.name.resize(arcs);
+    for (size_t i = 0; i < arcs; ++i)
+    {
+        uint32_t arc;
+        memcpy(&arc, data + VARIABLE_HEADER + i * sizeof(arc), sizeof(arc));
+        var.name[i] = arc;
+    }
+    var.value = data + VARIABLE_HEADER + arcs * sizeof(uint32_t);
+    var.length = length;
+
+    offset += size;
+    return true;
+}
+
+void Journal::encode(Record& record, const netsnmp_variable_list* vars)
+{
+    size_t offset = 0;
+    record.flags = 0;
+    for (auto var = vars; var; var = var->next_variable)
+    {
+        auto size = VARIABLE_HEADER + var->name_length * sizeof(uint32_t) +
+                    var->val_len;
+        if (var->name_length > UINT8_MAX || var->val_len > UINT16_MAX ||
+            offset + size > record.data.size())
+        {
+            record.flags |= TRUNCATED;
+            break;
+        }
+
+        auto data = record.data.data() + offset;
+        uint16_t length = var->val_len;
+        data[0] = var->type;
+        data[1] = static_cast<uint8_t>(var->name_length);
+        memcpy(data + 2, &length, sizeof(length));
+        for (size_t i = 0; i < var->name_length; ++i)
+        {
+            uint32_t arc = var->name[i];
+            memcpy(data + VARIABLE_HEADER + i * sizeof(arc), &arc,
+                   sizeof(arc));
+        }
+        if (var->val_len)
+        {
+            memcpy(data + VARIABLE_HEADER + var->name_length * sizeof(uint32_t),
+                   var->val.string, var->val_len);
+        }
+        offset += size;
+    }
+    record.length = static_cast<uint16_t>(offset);
+}
+
+uint32_t Journal::checksum(const Record& record)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    auto update = [&hash](const void* ptr, size_t size) {
+        auto bytes = static_cast<const uint8_t*>(ptr);
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+    };
+
+    update(&record.sequence, sizeof(record.sequence));
+    update(&record.time, sizeof(record.time));
+    update(&record.length, sizeof(record.length));
+    update(&record.flags, sizeof(record.flags));
+    update(record.data.data(),
+           std::min<size_t>(record.length, record.data.size()));
+    return hash;
+}
+
+bool Journal::valid(const Record& record, uint32_t sequence) const
+{
+    return 0 != sequence && record.sequence == sequence &&
+           record.length <= record.data.size() &&
+           record.checksum == checksum(record);
+}
+
+bool Journal::map()
+{
+    auto slash = path.rfind('/');
+    if (slash != std::string::npos && slash > 0)
+    {
+        // Only the last directory is created, like systemd StateDirectory.
+        mkdir(path.substr(0, slash).c_str(), 0755);
+    }
+
+    int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+    {
+        TRACE_ERROR("Can't open notification journal '%s': %s\n",
+                    path.c_str(), strerror(errno));
+        return false;
+    }
+    // Processes started at once must not recreate the file in turn,
+    // the lock is released by close().
+    flock(fd, LOCK_EX);
+
+    // The header takes place of the first record.
+    _size = (_capacity + 1) * recordSize;
+    struct stat st;
+    bool fresh =
+        0 != fstat(fd, &st) || static_cast<size_t>(st.st_size) != _size;
+    if (fresh && (0 != ftruncate(fd, 0) || 0 != ftruncate(fd, _size)))
+    {
+        TRACE_ERROR("Can't resize notification journal '%s': %s\n",
+                    path.c_str(), strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    auto base = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (MAP_FAILED == base)
+    {
+        TRACE_ERROR("Can't map notification journal '%s': %s\n",
+                    path.c_str(), strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    _base = static_cast<uint8_t*>(base);
+    _header = reinterpret_cast<Header*>(_base);
+    _records = reinterpret_cast<Record*>(_base + recordSize);
+
+    if (!fresh && (_header->magic != MAGIC || _header->version != VERSION ||
+                   _header->recordSize != recordSize ||
+                   _header->capacity != _capacity))
+    {
+        memset(_base, 0, _size);
+        fresh = true;
+    }
+
+    if (fresh)
+    {
+        TRACE_INFO("Notification journal '%s' created\n", path.c_str());
+        _header->magic = MAGIC;
+        _header->version = VERSION;
+        _header->recordSize = recordSize;
+        _header->capacity = _capacity;
+        _header->next = 1;
+        msync(_base, _size, MS_SYNC);
+    }
+
+    close(fd);
+    return true;
+}
+
+void Journal::flush()
+{
+    if (_flush)
+    {
+        _flush->stop();
+    }
+    if (0 == _dirtyFirst)
+    {
+        return;
+    }
+
+    static const size_t pageSize = sysconf(_SC_PAGESIZE);
+    auto sync = [this](size_t first, size_t last) {
+        auto begin = reinterpret_cast<uint8_t*>(&_records[first]);
+        auto end = reinterpret_cast<uint8_t*>(&_records[last + 1]);
+        // msync() requires page aligned address, the mapping starts
+        // at a page boundary.
+        begin = _base + (begin - _base) / pageSize * pageSize;
+        msync(begin, end - begin, MS_SYNC);
+    };
+
+    if (_dirtyLast - _dirtyFirst + 1 >= _capacity)
+    {
+        sync(0, _capacity - 1);
+    }
+    else
+    {
+        size_t first = _dirtyFirst % _capacity;
+        size_t last = _dirtyLast % _capacity;
+        if (first <= last)
+        {
+            sync(first, last);
+        }
+        else
+        {
+            sync(first, _capacity - 1);
+            sync(0, last);
+        }
+    }
+
+    _dirtyFirst = 0;
+    _dirtyLast = 0;
+    ++_flushed;
+}
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
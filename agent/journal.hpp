@@ -0,0 +1,270 @@
+/**
+ * @brief Persistent journal of the notifications.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+
+#include "scheduler.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+/**
+ * @brief Ring journal of the notifications in a memory mapped file.
+ *
+ * Every notification gets a sequence number and is written into a fixed
+ * size record, the oldest records are overwritten. Pages are written back
+ * by the kernel and synced with `journalFlush` period, so a burst of traps
+ * doesn't cause a flash write per trap. Records are validated with
+ * a checksum on start, the numbering continues after the last valid one.
+ *
+ * The next sequence number is kept in the mapped header, so several
+ * agent processes (see `-m` option) append to the same journal.
+ */
+class Journal
+{
+  public:
+    static constexpr size_t recordSize = 512;
+
+    /**
+     * @brief Journal record, sequence 0 means empty record.
+     */
+    struct Record
+    {
+        uint32_t sequence;
+        uint32_t checksum;
+        uint64_t time;   // Milliseconds since epoch
+        uint16_t length; // Bytes used in `data`
+        uint16_t flags;
+        std::array<uint8_t, recordSize - 20> data; // Encoded variables
+    };
+    static_assert(sizeof(Record) == recordSize, "Unexpected record layout");
+
+    /** @brief Not all variables fit into the record. */
+    static constexpr uint16_t TRUNCATED = 0x0001;
+
+    /**
+     * @brief Decoded variable of the record.
+     */
+    struct Variable
+    {
+        u_char type;
+        std::vector<oid> name;
+        const uint8_t* value;
+        size_t length;
+    };
+
+    /**
+     * @brief Journal file, no journal if empty.
+     */
+    inline static std::string path =
+        "/var/lib/yadro-snmp/notifications.journal";
+
+    /**
+     * @brief Number of records in the ring.
+     */
+    inline static size_t capacity = 1024;
+
+    /**
+     * @brief Period of syncing the written records to the storage,
+     *        0 - leave it to the kernel writeback.
+     */
+    inline static std::chrono::seconds flushInterval{10};
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Copy and move operations due to singleton.
+     *     Allowed:
+     *         - Default constructor.
+     *         - Destructor.
+     */
+    Journal() = default;
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+    Journal(Journal&&) = delete;
+    Journal& operator=(Journal&&) = delete;
+    ~Journal() = default;
+
+    /**
+     * @brief Process-wide journal.
+     */
+    static Journal& instance();
+
+    /**
+     * @brief Map the journal file and recover the sequence.
+     *
+     * The file is recreated if its layout doesn't match the settings.
+     */
+    void init();
+
+    /**
+     * @brief Sync and unmap the journal file.
+     */
+    void destroy();
+
+    /**
+     * @brief Write the notification into the journal.
+     *
+     * @param vars - Notification variables, starting with snmpTrapOID.0
+     *
+     * @return Sequence number of the record or 0 if there is no journal.
+     */
+    uint32_t append(const netsnmp_variable_list* vars);
+
+    /**
+     * @brief Find the record by sequence number.
+     *
+     * @return Pointer to the record or nullptr if it is overwritten.
+     */
+    const Record* find(uint32_t sequence) const;
+
+    /**
+     * @brief Find the first record after the sequence number.
+     *
+     * Stops at a record still being written by another process, so
+     * a walk never skips it and sees it on the next walk instead.
+     *
+     * @return Pointer to the record or nullptr if there are no newer ones
+     *         or the next one is not written yet.
+     */
+    const Record* next(uint32_t sequence) const;
+
+    /**
+     * @brief Decode variables of the record.
+     *
+     * @param record - Journal record
+     * @param func - Functor called as `func(const Variable&)`
+     */
+    template <typename Func>
+    static void forEach(const Record& record, Func&& func)
+    {
+        Variable var;
+        for (size_t offset = 0; decode(record, offset, var);)
+        {
+            func(var);
+        }
+    }
+
+    /** @brief Sequence number of the last record, 0 if empty. */
+    uint32_t last() const
+    {
+        return _header ? _header->next.load(std::memory_order_acquire) - 1
+                       : 0;
+    }
+
+    /** @brief Number of records written since start. */
+    uint64_t written() const
+    {
+        return _written;
+    }
+
+    /** @brief Number of syncs to the storage. */
+    uint64_t flushed() const
+    {
+        return _flushed;
+    }
+
+  private:
+    /**
+     * @brief File header, takes place of the first record.
+     */
+    struct Header
+    {
+        std::array<char, 8> magic;
+        uint32_t version;
+        uint32_t recordSize;
+        uint64_t capacity;
+        // Shared by the processes mapping the journal.
+        std::atomic<uint32_t> next;
+    };
+    static_assert(std::atomic<uint32_t>::is_always_lock_free,
+                  "Sequence can't be shared between processes");
+
+    /** @brief Decode variable at the offset and advance it. */
+    static bool decode(const Record& record, size_t& offset, Variable& var);
+
+    /** @brief Encode variables into the record. */
+    static void encode(Record& record, const netsnmp_variable_list* vars);
+
+    /** @brief Checksum of the record. */
+    static uint32_t checksum(const Record& record);
+
+    /** @brief Check if the record is valid and has the sequence number. */
+    bool valid(const Record& record, uint32_t sequence) const;
+
+    /** @brief Map the file and check its header. */
+    bool map();
+
+    /** @brief Sync dirty records to the storage. */
+    void flush();
+
+    /**
+     * @brief Check if the invalid record will never be written.
+     *
+     * The sequence is claimed before the record is written, the record
+     * is given `appendTimeout` to become valid, so the walks are not
+     * stuck forever if the writer has crashed.
+     */
+    bool lost(uint32_t sequence) const;
+
+    Record& slot(uint32_t sequence) const
+    {
+        return _records[sequence % _capacity];
+    }
+
+    uint8_t* _base = nullptr;
+    size_t _size = 0;
+    Header* _header = nullptr;
+    Record* _records = nullptr;
+    size_t _capacity = 0;
+
+    // Records up to this one were written before `init()`.
+    uint32_t _settled = 0;
+
+    // Invalid record the walks wait for.
+    static constexpr auto appendTimeout = std::chrono::seconds{1};
+    mutable uint32_t _waiting = 0;
+    mutable std::chrono::steady_clock::time_point _waitingSince;
+
+    // Range of records written since the last sync.
+    uint32_t _dirtyFirst = 0;
+    uint32_t _dirtyLast = 0;
+    std::unique_ptr<Timer> _flush;
+
+    uint64_t _written = 0;
+    uint64_t _flushed = 0;
+};
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
@@ -0,0 +1,73 @@
+/**
+ * @brief Event loop priorities and lag implementation.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "tracing.hpp"
+#include "loop.hpp"
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+Loop& Loop::instance()
+{
+    static Loop loop;
+    return loop;
+}
+
+void Loop::init(const sdeventplus::Event& event)
+{
+    if (lagInterval.count() <= 0)
+    {
+        return;
+    }
+
+    // The time is expected precisely, without sd-event coalescing.
+    _timer = std::make_unique<Time>(
+        event, clock_t(event).now() + lagInterval,
+        std::chrono::microseconds{1},
+        [this](Time& source, Time::TimePoint time) {
+            // The time of the loop wakeup, not the current one.
+            auto now = clock_t(source.get_event()).now();
+            _lag.add(now - time);
+            source.set_time(now + lagInterval);
+            source.set_enabled(sdeventplus::source::Enabled::OneShot);
+        });
+    _timer->set_priority(requestPriority);
+    DEBUGMSGTL(("loop", "Measure lag every %lld ms\n",
+                static_cast<long long>(lagInterval.count())));
+}
+
+void Loop::destroy()
+{
+    _timer.reset();
+    DEBUGMSGTL(("loop", "lag samples=%llu, avg=%lld us, p99=%lld us, "
+                "max=%lld us\n",
+                static_cast<unsigned long long>(_lag.count()),
+                static_cast<long long>(_lag.average().count()),
+                static_cast<long long>(_lag.percentile(99).count()),
+                static_cast<long long>(_lag.max().count())));
+}
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
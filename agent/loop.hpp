@@ -0,0 +1,118 @@
+/**
+ * @brief Event loop priorities and lag.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include "histogram.hpp"
+
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/time.hpp>
+#include <systemd/sd-event.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+/**
+ * @brief Priorities of the event sources and the loop lag.
+ *
+ * sd-event dispatches one source per iteration, the one of the highest
+ * priority (lowest value) among the pending. The SNMP request sources
+ * are given higher priority than the DBus connection, so a storm of
+ * signals delays a request by one signal handling at most. The sd-bus
+ * source handles a single message per iteration, so that is the budget
+ * of DBus processing between the requests.
+ *
+ * The lag is the delay of a timer of the request priority, i.e. how long
+ * a request waits for the loop.
+ */
+class Loop
+{
+  public:
+    using clock_t = sdeventplus::Clock<sdeventplus::ClockId::Monotonic>;
+
+    /**
+     * @brief Priority of SNMP requests: net-snmp and AgentX sockets.
+     */
+    inline static int64_t requestPriority = SD_EVENT_PRIORITY_IMPORTANT;
+
+    /**
+     * @brief Priority of DBus messages.
+     */
+    inline static int64_t dbusPriority = SD_EVENT_PRIORITY_NORMAL;
+
+    /**
+     * @brief Period of the lag measurement, 0 turns it off.
+     */
+    inline static std::chrono::milliseconds lagInterval{1000};
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Copy and move operations due to singleton.
+     *     Allowed:
+     *         - Default constructor.
+     *         - Destructor.
+     */
+    Loop() = default;
+    Loop(const Loop&) = delete;
+    Loop& operator=(const Loop&) = delete;
+    Loop(Loop&&) = delete;
+    Loop& operator=(Loop&&) = delete;
+    ~Loop() = default;
+
+    /**
+     * @brief Process-wide loop monitor.
+     */
+    static Loop& instance();
+
+    /**
+     * @brief Start the lag measurement.
+     */
+    void init(const sdeventplus::Event& event);
+
+    /**
+     * @brief Release the event source.
+     */
+    void destroy();
+
+    /** @brief Loop lag samples. */
+    const Histogram& lag() const
+    {
+        return _lag;
+    }
+
+  private:
+    using Time = sdeventplus::source::Time<sdeventplus::ClockId::Monotonic>;
+
+    std::unique_ptr<Time> _timer;
+    Histogram _lag;
+};
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
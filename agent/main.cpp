@@ -22,7 +22,9 @@
 #include "config.h"
 #include "tracing.hpp"
 #include "sdbusplus/helper.hpp"
+#include "loop.hpp"
 #include "snmp.hpp"
+#include "data/ingestion.hpp"
 
 #include <sdeventplus/event.hpp>
 #include <sdeventplus/source/signal.hpp>
@@ -31,12 +33,79 @@
 #include <net-snmp/net-snmp-includes.h>
 #include <net-snmp/agent/net-snmp-agent-includes.h>
 
+#include <algorithm>
 #include <csignal>
+#include <iterator>
+#include <string>
 
 #include "yadro/powerstate.hpp"
 #include "yadro/sensors.hpp"
 #include "yadro/software.hpp"
 #include "yadro/inventory.hpp"
+#include "yadro/notificationlog.hpp"
+#include "yadro/agentstats.hpp"
+#include "yadro/startup.hpp"
+
+/**
+ * @brief MIB module of the agent.
+ */
+struct Module
+{
+    const char* name;
+    void (*init)();
+    void (*destroy)();
+    bool enabled;
+};
+
+// In order of initialization, all are served unless `-m` is given.
+static Module modules[] = {
+    {"power", yadro::host::power::state::init,
+     yadro::host::power::state::destroy, true},
+    {"sensors", yadro::sensors::init, yadro::sensors::destroy, true},
+    {"software", yadro::software::init, yadro::software::destroy, true},
+    {"inventory", yadro::inventory::init, yadro::inventory::destroy, true},
+    {"notifications", yadro::notificationlog::init,
+     yadro::notificationlog::destroy, true},
+    // The last one, it reports the objects of the modules above.
+    {"stats", yadro::agentstats::init, yadro::agentstats::destroy, true},
+};
+
+/**
+ * @brief Serve only the modules of comma separated list.
+ *
+ * @return false if the list has unknown module.
+ */
+static bool select_modules(const char* list)
+{
+    for (auto& module : modules)
+    {
+        module.enabled = false;
+    }
+
+    std::string names(list);
+    size_t start = 0;
+    while (start <= names.length())
+    {
+        auto end = names.find(',', start);
+        if (end == std::string::npos)
+        {
+            end = names.length();
+        }
+        auto name = names.substr(start, end - start);
+        start = end + 1;
+
+        auto it = std::find_if(
+            std::begin(modules), std::end(modules),
+            [&name](const Module& module) { return name == module.name; });
+        if (it == std::end(modules))
+        {
+            TRACE_ERROR("Unknown module '%s'\n", name.c_str());
+            return false;
+        }
+        it->enabled = true;
+    }
+    return true;
+}
 
 void print_usage()
 {
@@ -44,6 +113,14 @@ void print_usage()
     fprintf(stderr, "  Version:  %s\n\nOPTIONS:\n", PACKAGE_VERSION);
     fprintf(stderr, "  -h,--help\t\tdisplay this help message\n");
     fprintf(stderr, "  -d\t\t\tdump sent and received SNMP packets\n");
+    fprintf(stderr, "  -M\t\t\trun as master agent instead of AgentX "
+                    "subagent\n");
+    fprintf(stderr, "  -m MODULE[,...]\tserve only the modules:");
+    for (const auto& module : modules)
+    {
+        fprintf(stderr, " %s", module.name);
+    }
+    fprintf(stderr, "\n");
     fprintf(
         stderr,
         "  -D[TOKEN[,...]]\tturn on debugging output for the given TOKEN(s)\n"
@@ -64,11 +141,16 @@ enum
 
 int parse_args(int argc, char** argv)
 {
-    constexpr auto Opts = "dD:L:h";
+    constexpr auto Opts = "dD:L:Mm:h";
+
+    // AgentX subagent of snmpd unless `-M` is given.
+    netsnmp_ds_set_boolean(NETSNMP_DS_APPLICATION_ID, NETSNMP_DS_AGENT_ROLE,
+                           SUB_AGENT);
 
     optind = 1;
     int arg;
     int rc = EC_SUCCESS;
+    bool sharded = false;
 
     while (EC_SUCCESS == rc && (arg = getopt(argc, argv, Opts)) != EOF)
     {
@@ -89,6 +171,19 @@ int parse_args(int argc, char** argv)
                 rc = snmp_log_options(optarg, argc, argv);
                 break;
 
+            case 'M':
+                netsnmp_ds_set_boolean(NETSNMP_DS_APPLICATION_ID,
+                                       NETSNMP_DS_AGENT_ROLE, MASTER_AGENT);
+                break;
+
+            case 'm':
+                sharded = true;
+                if (!select_modules(optarg))
+                {
+                    rc = EC_ERROR;
+                }
+                break;
+
             case 'h':
                 rc = EC_SHOW_USAGE;
                 break;
@@ -100,6 +195,15 @@ int parse_args(int argc, char** argv)
         }
     }
     DEBUGMSGTL(("parse_args", "finished: %d/%d\n", optind, argc));
+
+    // Processes serving parts of the MIB need the master to merge them.
+    if (EC_SUCCESS == rc && sharded &&
+        MASTER_AGENT == netsnmp_ds_get_boolean(NETSNMP_DS_APPLICATION_ID,
+                                               NETSNMP_DS_AGENT_ROLE))
+    {
+        TRACE_ERROR("-m can't be used with -M\n");
+        rc = EC_ERROR;
+    }
     return rc;
 }
 
@@ -124,8 +228,6 @@ int main(int argc, char* argv[])
     }
 
     auto evt = sdeventplus::Event::get_default();
-    sdbusplus::helper::helper::getBus().attach_event(evt.get(),
-                                                     SD_EVENT_PRIORITY_NORMAL);
 
     sigset_t ss;
     if (sigemptyset(&ss) < 0 || sigaddset(&ss, SIGTERM) < 0 ||
@@ -145,14 +247,31 @@ int main(int argc, char* argv[])
     sdeventplus::source::Signal sigterm(evt, SIGTERM, clean_exit);
     sdeventplus::source::Signal sigint(evt, SIGINT, clean_exit);
 
-    snmpagent_init(evt);
+    yadro::sensors::register_settings();
+    if (!snmpagent_init(evt))
+    {
+        return EXIT_FAILURE;
+    }
+
+    // The priority is configured by <PACKAGE_NAME>.conf.
+    sdbusplus::helper::helper::getBus().attach_event(
+        evt.get(), phosphor::snmp::agent::Loop::dbusPriority);
 
     // Initialize DBus and MIB objects
 
-    yadro::host::power::state::init();
-    yadro::sensors::init();
-    yadro::software::init();
-    yadro::inventory::init();
+    yadro::startup::init();
+    for (const auto& module : modules)
+    {
+        if (module.enabled)
+        {
+            DEBUGMSGTL(("snmpagent:init", "Serve module '%s'\n", module.name));
+            module.init();
+        }
+    }
+    yadro::startup::release();
+
+    // The tables of the modules are watched by now.
+    phosphor::snmp::data::Ingestion::instance().start(evt);
 
     // main loop
 
@@ -162,12 +281,18 @@ int main(int argc, char* argv[])
 
     TRACE_INFO("%s shuting down.\n", PACKAGE_STRING);
 
+    phosphor::snmp::data::Ingestion::instance().stop();
+
     // Release DBus and MIB objects resources
 
-    yadro::inventory::destroy();
-    yadro::software::destroy();
-    yadro::sensors::destroy();
-    yadro::host::power::state::destroy();
+    for (auto it = std::rbegin(modules); it != std::rend(modules); ++it)
+    {
+        if (it->enabled)
+        {
+            it->destroy();
+        }
+    }
+    yadro::startup::destroy();
 
     snmpagent_destroy();
 
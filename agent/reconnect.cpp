@@ -0,0 +1,109 @@
+/**
+ * @brief Reconnection of the AgentX sessions implementation.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "tracing.hpp"
+#include "reconnect.hpp"
+
+#include <algorithm>
+#include <random>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+Reconnect::~Reconnect()
+{
+    using std::chrono::duration_cast;
+    using std::chrono::milliseconds;
+
+    DEBUGMSGTL(("agentx:reconnect",
+                "%s: outages=%llu, attempts=%llu, last=%lld ms, "
+                "max=%lld ms, total=%lld ms\n",
+                _name.c_str(), static_cast<unsigned long long>(_outages),
+                static_cast<unsigned long long>(_attempts),
+                static_cast<long long>(
+                    duration_cast<milliseconds>(_lastOutage).count()),
+                static_cast<long long>(
+                    duration_cast<milliseconds>(_maxOutage).count()),
+                static_cast<long long>(
+                    duration_cast<milliseconds>(_totalOutage).count())));
+}
+
+void Reconnect::down()
+{
+    auto now = clock_t::now();
+    if (_connected)
+    {
+        _connected = false;
+        _failures = 0;
+        _since = now;
+        ++_outages;
+        TRACE_WARNING("%s: session lost\n", _name.c_str());
+    }
+    else if (!_since)
+    {
+        // Not connected yet since the start.
+        _since = now;
+    }
+
+    std::chrono::milliseconds delay = minDelay;
+    for (size_t i = 0; i < _failures && delay < maxDelay; ++i)
+    {
+        delay *= 2;
+    }
+    delay = std::max(std::min(delay, maxDelay), std::chrono::milliseconds(1));
+    ++_failures;
+
+    static std::minstd_rand random(std::random_device{}());
+    std::uniform_int_distribution<std::chrono::milliseconds::rep> jitter(
+        delay.count() / 2, delay.count());
+    _timer.start(std::chrono::milliseconds(jitter(random)));
+
+    DEBUGMSGTL(("agentx:reconnect", "%s: attempt %zu in %lld ms\n",
+                _name.c_str(), _failures,
+                static_cast<long long>(delay.count())));
+}
+
+void Reconnect::up()
+{
+    _timer.stop();
+    _connected = true;
+    _failures = 0;
+
+    if (_since && _outages)
+    {
+        _lastOutage = clock_t::now() - *_since;
+        _maxOutage = std::max(_maxOutage, _lastOutage);
+        _totalOutage += _lastOutage;
+        TRACE_INFO("%s: session reopened after %lld ms\n", _name.c_str(),
+                   static_cast<long long>(
+                       std::chrono::duration_cast<std::chrono::milliseconds>(
+                           _lastOutage)
+                           .count()));
+    }
+    _since.reset();
+}
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
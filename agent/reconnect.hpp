@@ -0,0 +1,160 @@
+/**
+ * @brief Reconnection of the AgentX sessions.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include "scheduler.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+/**
+ * @brief Reconnection to the AgentX master with backoff.
+ *
+ * The delay before the next attempt starts at `minDelay` and doubles
+ * with every failed attempt up to `maxDelay`. The actual delay is picked
+ * at random from the upper half of it, so the subagents don't hammer
+ * the restarted master all at once.
+ */
+class Reconnect
+{
+  public:
+    using clock_t = std::chrono::steady_clock;
+
+    /**
+     * @brief Delay before the first attempt.
+     */
+    inline static std::chrono::milliseconds minDelay{500};
+
+    /**
+     * @brief Max delay between attempts.
+     */
+    inline static std::chrono::milliseconds maxDelay{30000};
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Default constructor to avoid empty callback.
+     *         - Copy and move operations due to the timer.
+     *     Allowed:
+     *         - Destructor.
+     */
+    Reconnect() = delete;
+    Reconnect(const Reconnect&) = delete;
+    Reconnect& operator=(const Reconnect&) = delete;
+    Reconnect(Reconnect&&) = delete;
+    Reconnect& operator=(Reconnect&&) = delete;
+    ~Reconnect();
+
+    /**
+     * @brief Object constructor
+     *
+     * @param name - Session name for the log
+     * @param connect - Connection attempt
+     */
+    Reconnect(const std::string& name, Timer::callback_t&& connect) :
+        _name(name), _timer([this, connect = std::move(connect)]() {
+            ++_attempts;
+            connect();
+        })
+    {
+    }
+
+    /**
+     * @brief Session is lost or the attempt failed, schedule the next one.
+     */
+    void down();
+
+    /**
+     * @brief Session is opened.
+     */
+    void up();
+
+    /**
+     * @brief Cancel the scheduled attempt.
+     */
+    void cancel()
+    {
+        _timer.stop();
+    }
+
+    /** @brief Check if the session is open. */
+    bool connected() const
+    {
+        return _connected;
+    }
+
+    /** @brief Number of the sessions lost. */
+    uint64_t outages() const
+    {
+        return _outages;
+    }
+
+    /** @brief Number of the connection attempts. */
+    uint64_t attempts() const
+    {
+        return _attempts;
+    }
+
+    /** @brief Time from the loss of the session to the last reconnection. */
+    clock_t::duration lastOutage() const
+    {
+        return _lastOutage;
+    }
+
+    /** @brief Longest time without the session. */
+    clock_t::duration maxOutage() const
+    {
+        return _maxOutage;
+    }
+
+    /** @brief Overall time without the session after it was lost. */
+    clock_t::duration totalOutage() const
+    {
+        return _totalOutage;
+    }
+
+  private:
+    std::string _name;
+    Timer _timer;
+    bool _connected = false;
+    // Failed attempts since the session was lost.
+    size_t _failures = 0;
+    // Start of the outage, empty while connected.
+    std::optional<clock_t::time_point> _since;
+
+    uint64_t _outages = 0;
+    uint64_t _attempts = 0;
+    clock_t::duration _lastOutage{};
+    clock_t::duration _maxOutage{};
+    clock_t::duration _totalOutage{};
+};
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
@@ -0,0 +1,276 @@
+/**
+ * @brief Shared timers on the event loop implementation.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "tracing.hpp"
+#include "scheduler.hpp"
+
+#include <algorithm>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+size_t Scheduler::Level::next(size_t from) const
+{
+    for (size_t distance = 1; distance <= slots;)
+    {
+        auto index = (from + distance) & (slots - 1);
+        auto bit = index % 64;
+        auto word = occupied[index / 64] >> bit;
+        if (word)
+        {
+            // Bits past the full turn were checked first, so they are clear.
+            return distance + __builtin_ctzll(word);
+        }
+        distance += 64 - bit;
+    }
+    return 0;
+}
+
+Scheduler& Scheduler::instance()
+{
+    static Scheduler scheduler;
+    return scheduler;
+}
+
+void Scheduler::init(const sdeventplus::Event& event)
+{
+    _event.emplace(event);
+    _source = std::make_unique<Time>(
+        event, clock_t(event).now(), std::chrono::milliseconds{1},
+        [this](Time&, Time::TimePoint) {
+            _armed.reset();
+            advance(now());
+            auto next = nextEvent();
+            if (next)
+            {
+                arm(*next);
+            }
+        });
+    _source->set_enabled(sdeventplus::source::Enabled::Off);
+    _current = now();
+}
+
+void Scheduler::destroy()
+{
+    for (auto& level : _levels)
+    {
+        for (auto& head : level.heads)
+        {
+            for (auto timer = head; timer; timer = timer->_next)
+            {
+                timer->_running = false;
+            }
+            head = nullptr;
+        }
+        level.occupied.fill(0);
+    }
+    _size = 0;
+    _armed.reset();
+    _source.reset();
+    _event.reset();
+}
+
+bool Scheduler::add(Timer* timer, clock_t::duration timeout)
+{
+    if (!_event)
+    {
+        TRACE_ERROR("Timer can't be started before the scheduler\n");
+        return false;
+    }
+
+    auto time = clock_t(*_event).now();
+    uint64_t current =
+        std::chrono::duration_cast<tick_t>(time.time_since_epoch()).count();
+    if (0 == _size)
+    {
+        // Nothing to expire in between, so the wheel can jump forward.
+        _current = std::max(_current, current);
+    }
+
+    // Round up, so the timer never expires earlier than requested.
+    auto deadline = time + timeout;
+    uint64_t expires =
+        std::chrono::ceil<tick_t>(deadline.time_since_epoch()).count();
+    expires = std::max(expires, std::max(current, _current) + 1);
+    expires = std::min(expires, _current + maxTicks - 1);
+
+    timer->_expires = expires;
+    link(timer);
+    ++_size;
+
+    // The timer of upper level is due when its slot is redistributed.
+    auto shift = timer->_level * slotBits;
+    auto wake = (expires >> shift) << shift;
+    if (!_armed || wake < *_armed)
+    {
+        arm(wake);
+    }
+    return true;
+}
+
+void Scheduler::remove(Timer* timer)
+{
+    unlink(timer);
+    if (0 == --_size && _source)
+    {
+        _source->set_enabled(sdeventplus::source::Enabled::Off);
+        _armed.reset();
+    }
+}
+
+void Scheduler::link(Timer* timer)
+{
+    auto delta = timer->_expires - _current;
+    size_t level = 0;
+    while (level + 1 < levels && delta >> ((level + 1) * slotBits))
+    {
+        ++level;
+    }
+
+    auto index = (timer->_expires >> (level * slotBits)) & (slots - 1);
+    auto& slot = _levels[level].heads[index];
+
+    timer->_level = static_cast<uint8_t>(level);
+    timer->_prev = nullptr;
+    timer->_next = slot;
+    if (slot)
+    {
+        slot->_prev = timer;
+    }
+    slot = timer;
+    _levels[level].occupied[index / 64] |= uint64_t(1) << (index % 64);
+}
+
+void Scheduler::unlink(Timer* timer)
+{
+    auto& level = _levels[timer->_level];
+    auto index =
+        (timer->_expires >> (timer->_level * slotBits)) & (slots - 1);
+
+    if (timer->_prev)
+    {
+        timer->_prev->_next = timer->_next;
+    }
+    else
+    {
+        level.heads[index] = timer->_next;
+    }
+    if (timer->_next)
+    {
+        timer->_next->_prev = timer->_prev;
+    }
+    if (!level.heads[index])
+    {
+        level.occupied[index / 64] &= ~(uint64_t(1) << (index % 64));
+    }
+    timer->_prev = nullptr;
+    timer->_next = nullptr;
+}
+
+uint64_t Scheduler::now() const
+{
+    return std::chrono::duration_cast<tick_t>(
+               clock_t(*_event).now().time_since_epoch())
+        .count();
+}
+
+std::optional<uint64_t> Scheduler::nextEvent() const
+{
+    std::optional<uint64_t> next;
+    for (size_t level = 0; level < levels; ++level)
+    {
+        auto shift = level * slotBits;
+        auto position = _current >> shift;
+        auto distance = _levels[level].next(position & (slots - 1));
+        if (distance)
+        {
+            auto tick = (position + distance) << shift;
+            if (!next || tick < *next)
+            {
+                next = tick;
+            }
+        }
+    }
+    return next;
+}
+
+void Scheduler::advance(uint64_t to)
+{
+    for (auto next = nextEvent(); next && *next <= to; next = nextEvent())
+    {
+        _current = *next;
+
+        // Redistribute timers of the upper levels whose slots are due.
+        for (size_t level = levels - 1; level > 0; --level)
+        {
+            auto shift = level * slotBits;
+            if (_current & ((uint64_t(1) << shift) - 1))
+            {
+                continue;
+            }
+
+            auto index = (_current >> shift) & (slots - 1);
+            auto timer = _levels[level].heads[index];
+            _levels[level].heads[index] = nullptr;
+            _levels[level].occupied[index / 64] &=
+                ~(uint64_t(1) << (index % 64));
+            while (timer)
+            {
+                auto following = timer->_next;
+                link(timer);
+                timer = following;
+            }
+        }
+
+        // All timers of the lowest level slot expire at the same tick.
+        auto& slot = _levels[0].heads[_current & (slots - 1)];
+        while (slot)
+        {
+            auto timer = slot;
+            unlink(timer);
+            --_size;
+            timer->_running = false;
+            ++_fired;
+            // The callback may start and stop any timers, including this one.
+            timer->_callback();
+        }
+    }
+    _current = std::max(_current, to);
+}
+
+void Scheduler::arm(uint64_t tick)
+{
+    if (!_source)
+    {
+        return;
+    }
+
+    _source->set_time(clock_t::time_point(tick_t(tick)));
+    _source->set_enabled(sdeventplus::source::Enabled::OneShot);
+    _armed = tick;
+}
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
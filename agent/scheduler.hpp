@@ -0,0 +1,238 @@
+/**
+ * @brief Shared timers on the event loop.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/time.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+class Timer;
+
+/**
+ * @brief Scheduler of the timers.
+ *
+ * All timers are kept in a hierarchical timer wheel served by one event
+ * source, so thousands of table rows don't need their own timer sources.
+ * The wheel has 4 levels of 256 slots with 1 ms tick, so timeouts up to
+ * 49 days are supported. Timers are linked into the slots intrusively,
+ * start and stop cost O(1).
+ */
+class Scheduler
+{
+  public:
+    using clock_t = sdeventplus::Clock<sdeventplus::ClockId::Monotonic>;
+    using tick_t = std::chrono::milliseconds;
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Copy and move operations due to singleton.
+     *     Allowed:
+     *         - Default constructor.
+     *         - Destructor.
+     */
+    Scheduler() = default;
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+    Scheduler(Scheduler&&) = delete;
+    Scheduler& operator=(Scheduler&&) = delete;
+    ~Scheduler() = default;
+
+    /**
+     * @brief Process-wide scheduler.
+     */
+    static Scheduler& instance();
+
+    /**
+     * @brief Attach to the event loop.
+     *
+     * Timers can't be started until this is called.
+     */
+    void init(const sdeventplus::Event& event);
+
+    /**
+     * @brief Stop all timers and release the event source.
+     */
+    void destroy();
+
+    /** @brief Number of running timers. */
+    size_t size() const
+    {
+        return _size;
+    }
+
+    /** @brief Number of expired timers. */
+    uint64_t fired() const
+    {
+        return _fired;
+    }
+
+  private:
+    friend class Timer;
+
+    static constexpr size_t levels = 4;
+    static constexpr size_t slotBits = 8;
+    static constexpr size_t slots = 1 << slotBits;
+    static constexpr uint64_t maxTicks = uint64_t(1) << (levels * slotBits);
+
+    /**
+     * @brief Occupied slots of the level.
+     */
+    struct Level
+    {
+        std::array<Timer*, slots> heads{};
+        std::array<uint64_t, slots / 64> occupied{};
+
+        /**
+         * @brief Distance to the next occupied slot after `from`,
+         *        `slots` means the same slot, 0 - the level is empty.
+         */
+        size_t next(size_t from) const;
+    };
+
+    /** @brief Queue the timer, called by `Timer::start()`. */
+    bool add(Timer* timer, clock_t::duration timeout);
+
+    /** @brief Dequeue the timer, called by `Timer::stop()`. */
+    void remove(Timer* timer);
+
+    /** @brief Link the timer into the slot by its expiration tick. */
+    void link(Timer* timer);
+
+    /** @brief Unlink the timer from its slot. */
+    void unlink(Timer* timer);
+
+    /** @brief Get current tick of the event loop clock. */
+    uint64_t now() const;
+
+    /** @brief Get the next tick when the wheel has work to do. */
+    std::optional<uint64_t> nextEvent() const;
+
+    /** @brief Move the wheel up to the tick calling expired timers. */
+    void advance(uint64_t to);
+
+    /** @brief Arm the event source for the tick. */
+    void arm(uint64_t tick);
+
+    using Time = sdeventplus::source::Time<sdeventplus::ClockId::Monotonic>;
+
+    std::optional<sdeventplus::Event> _event;
+    std::unique_ptr<Time> _source;
+    std::optional<uint64_t> _armed;
+
+    std::array<Level, levels> _levels;
+    uint64_t _current = 0;
+    size_t _size = 0;
+    uint64_t _fired = 0;
+};
+
+/**
+ * @brief One-shot timer served by the scheduler.
+ */
+class Timer
+{
+  public:
+    using callback_t = std::function<void()>;
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Default constructor to avoid empty callback.
+     *         - Copy and move operations due to the scheduler
+     *           refers to the timer.
+     *     Allowed:
+     *         - Destructor.
+     */
+    Timer() = delete;
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+    Timer(Timer&&) = delete;
+    Timer& operator=(Timer&&) = delete;
+
+    explicit Timer(callback_t&& callback) : _callback(std::move(callback))
+    {
+    }
+
+    ~Timer()
+    {
+        stop();
+    }
+
+    /**
+     * @brief (Re)start the timer.
+     *
+     * @param timeout - Time until the callback is called, rounded up
+     *                  to the scheduler tick
+     */
+    void start(Scheduler::clock_t::duration timeout)
+    {
+        stop();
+        _running = Scheduler::instance().add(this, timeout);
+    }
+
+    /**
+     * @brief Stop the timer if it is running.
+     */
+    void stop()
+    {
+        if (_running)
+        {
+            Scheduler::instance().remove(this);
+            _running = false;
+        }
+    }
+
+    /**
+     * @brief Check if the timer is running.
+     */
+    bool running() const
+    {
+        return _running;
+    }
+
+  private:
+    friend class Scheduler;
+
+    callback_t _callback;
+    bool _running = false;
+
+    // Position in the wheel
+    Timer* _prev = nullptr;
+    Timer* _next = nullptr;
+    uint64_t _expires = 0;
+    uint8_t _level = 0;
+};
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
@@ -0,0 +1,169 @@
+/**
+ * @brief Agent configuration file directives.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+
+#include <cstdlib>
+#include <functional>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+namespace settings
+{
+
+/**
+ * @brief Directive parser, receives the rest of line after the token.
+ */
+using parser_t = std::function<void(char* line)>;
+
+namespace details
+{
+
+inline std::map<std::string, parser_t>& parsers()
+{
+    static std::map<std::string, parser_t> instance;
+    return instance;
+}
+
+/**
+ * @brief Directives added before the agent library initialization.
+ */
+inline std::vector<std::pair<const char*, const char*>>& deferred()
+{
+    static std::vector<std::pair<const char*, const char*>> instance;
+    return instance;
+}
+
+inline bool& ready()
+{
+    static bool instance = false;
+    return instance;
+}
+
+/**
+ * @brief Common net-snmp config handler for all our directives.
+ */
+inline void parse(const char* token, char* line)
+{
+    auto it = parsers().find(token);
+    if (it != parsers().end())
+    {
+        it->second(line);
+    }
+}
+
+} // namespace details
+
+/**
+ * @brief Register directives added before `init()`.
+ *
+ * Should be called after `init_agent()`, since the config handlers
+ * are bound to the application type.
+ */
+inline void init()
+{
+    details::ready() = true;
+    for (const auto& it : details::deferred())
+    {
+        register_app_config_handler(it.first, details::parse, nullptr,
+                                    it.second);
+    }
+    details::deferred().clear();
+}
+
+/**
+ * @brief Register directive with custom parser.
+ *
+ * Should be called before `init_snmp()`, the directives are read
+ * from <PACKAGE_NAME>.conf files. Directives added before `init()`
+ * are registered by it.
+ *
+ * @param token - Directive name
+ * @param parser - Directive parser
+ * @param help - Arguments description
+ */
+inline void add(const char* token, parser_t&& parser, const char* help)
+{
+    details::parsers().emplace(token, std::move(parser));
+    if (details::ready())
+    {
+        register_app_config_handler(token, details::parse, nullptr, help);
+    }
+    else
+    {
+        details::deferred().emplace_back(token, help);
+    }
+}
+
+/**
+ * @brief Parse integral value of directive.
+ *
+ * @return false if line does not contain a number.
+ */
+template <typename T> bool parse(char*& line, T& value)
+{
+    char* end = nullptr;
+    auto v = strtoll(line, &end, 0);
+    if (end == line)
+    {
+        return false;
+    }
+    line = end;
+    value = static_cast<T>(v);
+    return true;
+}
+
+/**
+ * @brief Register directive for integral setting.
+ *
+ * @param token - Directive name
+ * @param value - Reference to the setting
+ * @param help - Arguments description
+ */
+template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+void add(const char* token, T& value, const char* help)
+{
+    add(token,
+        [token, &value](char* line) {
+            if (!parse(line, value))
+            {
+                config_perror("numeric value expected");
+                DEBUGMSGTL(("settings", "Invalid value of '%s'\n", token));
+            }
+        },
+        help);
+}
+
+} // namespace settings
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
@@ -20,6 +20,17 @@
  */
 #include "config.h"
 #include "tracing.hpp"
+#include "agentx.hpp"
+#include "informsender.hpp"
+#include "journal.hpp"
+#include "loop.hpp"
+#include "reconnect.hpp"
+#include "scheduler.hpp"
+#include "settings.hpp"
+#include "snmp.hpp"
+#include "trapdispatcher.hpp"
+#include "data/ingestion.hpp"
+#include "data/population.hpp"
 
 #include <sdeventplus/clock.hpp>
 #include <sdeventplus/event.hpp>
@@ -30,8 +41,14 @@
 #include <net-snmp/net-snmp-config.h>
 #include <net-snmp/net-snmp-includes.h>
 #include <net-snmp/agent/net-snmp-agent-includes.h>
+#include <net-snmp/agent/mib_modules.h>
 
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <map>
+#include <memory>
+#include <optional>
 
 constexpr auto clockId = sdeventplus::ClockId::Monotonic;
 using Clock = sdeventplus::Clock<clockId>;
@@ -39,6 +56,24 @@ using Time = sdeventplus::source::Time<clockId>;
 
 // list of snmp file descriptors attached to sd_event loop.
 static std::map<int, sdeventplus::source::IO> snmp_fds;
+// Descriptors of the last update, the map is rebuilt only if they differ.
+static fd_set snmp_fdset;
+static int snmp_maxfd = 0;
+
+// net-snmp timeout, armed only if the deadline has changed.
+static std::unique_ptr<Time> snmp_timer;
+static std::optional<Clock::time_point> snmp_deadline;
+
+// Update of descriptors and timeout, run once after net-snmp activity.
+static std::unique_ptr<sdeventplus::source::Defer> snmp_update;
+static uint64_t snmp_updates = 0;
+
+// Reconnection of the AgentX subagent session.
+static std::unique_ptr<phosphor::snmp::agent::Reconnect> snmp_reconnect;
+
+// Exported by net-snmp agentx/subagent.c, the header is not installed.
+// Opens the session and re-registers all MIB regions if succeeded.
+extern "C" void agentx_reopen_session(unsigned int clientreg, void* clientarg);
 
 /** @brief Called when snmp file descriptors have data for reading. */
 static void sdevent_snmp_read(sdeventplus::source::IO& /*source*/, int fd,
@@ -49,35 +84,61 @@ static void sdevent_snmp_read(sdeventplus::source::IO& /*source*/, int fd,
     FD_ZERO(&fdset);
     FD_SET(fd, &fdset);
     snmp_read(&fdset);
+    snmpagent_update();
 }
 
-/** @brief Refresh list of snmp file descriptors. */
+/** @brief Called when net-snmp timeout expires. */
+static void sdevent_snmp_timeout(Time& /*source*/, Time::TimePoint /*time*/)
+{
+    DEBUGMSGTL(("snmpagent:handle", "Time out\n"));
+    snmp_deadline.reset();
+    snmp_timeout();
+    run_alarms();
+    snmpagent_update();
+}
+
+/** @brief Refresh list of snmp file descriptors and the timeout. */
 static void sdevent_snmp_update(const sdeventplus::Event& event)
 {
+    ++snmp_updates;
     netsnmp_check_outstanding_agent_requests();
 
     int maxfd = 0;
     int is_blocked = 1;
     fd_set fdset;
-    timeval timeout;
+    timeval timeout = {0, 0};
 
     FD_ZERO(&fdset);
     snmp_select_info(&maxfd, &fdset, &timeout, &is_blocked);
 
-    static Time snmpTimer(event, {}, std::chrono::microseconds{1},
-                          [](Time&, Time::TimePoint) {
-                              DEBUGMSGTL(("snmpagent:handle", "Time out\n"));
-                              snmp_timeout();
-                              run_alarms();
-                          });
+    if (!is_blocked)
+    {
+        auto deadline = Clock(event).now() +
+                        std::chrono::seconds{timeout.tv_sec} +
+                        std::chrono::microseconds{timeout.tv_usec};
+        // The timeout is relative to the net-snmp clock, so the same
+        // deadline differs a bit from pass to pass.
+        if (!snmp_deadline ||
+            std::chrono::abs(deadline - *snmp_deadline) >=
+                std::chrono::milliseconds{1})
+        {
+            snmp_timer->set_time(deadline);
+            snmp_timer->set_enabled(sdeventplus::source::Enabled::OneShot);
+            snmp_deadline = deadline;
+        }
+    }
+    else if (snmp_deadline)
+    {
+        snmp_timer->set_enabled(sdeventplus::source::Enabled::Off);
+        snmp_deadline.reset();
+    }
 
-    if (timeout.tv_sec || timeout.tv_usec)
+    if (maxfd == snmp_maxfd && 0 == memcmp(&fdset, &snmp_fdset, sizeof(fdset)))
     {
-        snmpTimer.set_time(Clock(event).now() +
-                           std::chrono::seconds{timeout.tv_sec} +
-                           std::chrono::microseconds{timeout.tv_usec});
-        snmpTimer.set_enabled(sdeventplus::source::Enabled::OneShot);
+        return;
     }
+    snmp_maxfd = maxfd;
+    snmp_fdset = fdset;
 
     // We need to untrack any event whose FD is not in `fdset` anymore.
     for (auto it = snmp_fds.begin(); it != snmp_fds.end();)
@@ -102,39 +163,391 @@ static void sdevent_snmp_update(const sdeventplus::Event& event)
         if (FD_ISSET(fd, &fdset))
         {
             DEBUGMSGTL(("snmpagent:handle", "Add fd=%d to set.\n", fd));
-            snmp_fds.emplace(fd, sdeventplus::source::IO(event, fd, EPOLLIN,
-                                                         sdevent_snmp_read));
+            auto it = snmp_fds.emplace(
+                fd, sdeventplus::source::IO(event, fd, EPOLLIN,
+                                            sdevent_snmp_read));
+            it.first->second.set_priority(
+                phosphor::snmp::agent::Loop::requestPriority);
         }
     }
 }
 
-/** @brief Initialize snmp agent */
-void snmpagent_init(const sdeventplus::Event& event)
+/**
+ * @brief Called by net-snmp when AgentX session is opened or lost.
+ *
+ * The loss is noticed when the IO source of the session reports EOF.
+ */
+static int snmp_session_changed(int /*majorID*/, int minorID,
+                                void* /*serverarg*/, void* /*clientarg*/)
+{
+    if (!snmp_reconnect)
+    {
+        return SNMPERR_SUCCESS;
+    }
+
+    if (SNMPD_CALLBACK_INDEX_START == minorID)
+    {
+        snmp_reconnect->up();
+    }
+    else
+    {
+        snmp_reconnect->down();
+    }
+    return SNMPERR_SUCCESS;
+}
+
+/** @brief Attempt to reopen AgentX session. */
+static void snmp_reopen()
+{
+    agentx_reopen_session(0, nullptr);
+    snmpagent_update();
+    if (!snmp_reconnect->connected())
+    {
+        snmp_reconnect->down();
+    }
+}
+
+void snmpagent_update()
+{
+    if (snmp_update)
+    {
+        snmp_update->set_enabled(sdeventplus::source::Enabled::OneShot);
+    }
+}
+
+uint64_t snmpagent_updates()
+{
+    return snmp_updates;
+}
+
+const phosphor::snmp::agent::Reconnect* snmpagent_reconnect()
+{
+    return snmp_reconnect.get();
+}
+
+/**
+ * @brief Parse trap limit directive arguments.
+ *
+ * @param line - Directive arguments: RATE BURST
+ * @param limit - Limit to fill
+ */
+static void
+    parse_trap_limit(char* line,
+                     phosphor::snmp::agent::TrapDispatcher::Limit& limit)
 {
-    // make us a agentx client
-    netsnmp_ds_set_boolean(NETSNMP_DS_APPLICATION_ID, NETSNMP_DS_AGENT_ROLE, 1);
+    char* end = nullptr;
+    double rate = strtod(line, &end);
+    if (end == line || rate < 0)
+    {
+        config_perror("non-negative rate expected");
+        return;
+    }
+
+    line = end;
+    double burst = strtod(line, &end);
+    if (end == line)
+    {
+        burst = rate;
+    }
+
+    limit.rate = rate;
+    // At least one trap should pass through the bucket.
+    limit.burst = std::max(burst, 1.);
+}
 
+/** @brief Register directives of <PACKAGE_NAME>.conf */
+static void register_settings()
+{
+    using namespace phosphor::snmp;
+
+    agent::settings::add("populateWindow", data::Population::window,
+                         "N (max DBus requests in flight per table, "
+                         "0 - synchronous population)");
+    agent::settings::add(
+        "populateStrategy",
+        [](char* line) {
+            char word[32];
+            copy_nword(line, word, sizeof(word));
+            if (0 == strcmp(word, "perObject"))
+            {
+                data::Population::strategy =
+                    data::Population::Strategy::PerObject;
+            }
+            else if (0 == strcmp(word, "managedObjects"))
+            {
+                data::Population::strategy =
+                    data::Population::Strategy::ManagedObjects;
+            }
+            else
+            {
+                config_perror("perObject or managedObjects expected");
+            }
+        },
+        "perObject|managedObjects");
+    agent::settings::add(
+        "trapLimit",
+        [](char* line) {
+            parse_trap_limit(line, agent::TrapDispatcher::notifyLimit);
+        },
+        "RATE [BURST] (traps per second for each notification type, "
+        "0 - unlimited)");
+    agent::settings::add(
+        "trapRowLimit",
+        [](char* line) {
+            parse_trap_limit(line, agent::TrapDispatcher::rowLimit);
+        },
+        "RATE [BURST] (traps per second for each table row, "
+        "0 - unlimited)");
+    agent::settings::add("trapQueueSize", agent::TrapDispatcher::queueSize,
+                         "N (max traps waiting to be sent)");
+    agent::settings::add("trapQueueBatch", agent::TrapDispatcher::queueBatch,
+                         "N (max traps sent per event loop iteration)");
+    agent::settings::add(
+        "trapQueueOverflow",
+        [](char* line) {
+            char word[32];
+            copy_nword(line, word, sizeof(word));
+            if (0 == strcmp(word, "dropOldest"))
+            {
+                agent::TrapDispatcher::queueOverflow =
+                    agent::TrapDispatcher::Overflow::DropOldest;
+            }
+            else if (0 == strcmp(word, "dropNewest"))
+            {
+                agent::TrapDispatcher::queueOverflow =
+                    agent::TrapDispatcher::Overflow::DropNewest;
+            }
+            else
+            {
+                config_perror("dropOldest or dropNewest expected");
+            }
+        },
+        "dropOldest|dropNewest");
+    agent::settings::add("startupSummary", agent::TrapDispatcher::startupMode,
+                         "1|0 (send single summary instead of row traps "
+                         "while tables are populated)");
+    agent::settings::add(
+        "informTarget",
+        [](char* line) {
+            char peer[256] = "";
+            char community[256] = "public";
+            line = copy_nword(line, peer, sizeof(peer));
+            if (!*peer)
+            {
+                config_perror("inform target host expected");
+                return;
+            }
+            if (line)
+            {
+                copy_nword(line, community, sizeof(community));
+            }
+            agent::InformSender::targets.push_back({peer, community});
+        },
+        "HOST[:PORT] [COMMUNITY] (send notifications as informs too)");
+    agent::settings::add(
+        "informTimeout",
+        [](char* line) {
+            auto value = strtoul(line, nullptr, 10);
+            if (0 == value)
+            {
+                config_perror("timeout in milliseconds expected");
+                return;
+            }
+            agent::InformSender::timeout = std::chrono::milliseconds(value);
+        },
+        "MS (time to wait for inform acknowledgement)");
+    agent::settings::add(
+        "informBackoffMax",
+        [](char* line) {
+            auto value = strtoul(line, nullptr, 10);
+            if (0 == value)
+            {
+                config_perror("backoff in milliseconds expected");
+                return;
+            }
+            agent::InformSender::maxBackoff = std::chrono::milliseconds(value);
+        },
+        "MS (max delay before inform retransmission)");
+    agent::settings::add("informRetries", agent::InformSender::retries,
+                         "N (retransmissions before inform is dropped)");
+    agent::settings::add("informOutstanding",
+                         agent::InformSender::outstanding,
+                         "N (max unacknowledged informs per target)");
+    agent::settings::add("informQueueSize", agent::InformSender::queueSize,
+                         "N (max informs queued per target)");
+    agent::settings::add(
+        "journalFile",
+        [](char* line) {
+            char path[PATH_MAX];
+            copy_nword(line, path, sizeof(path));
+            agent::Journal::path = path;
+        },
+        "PATH (notification journal, empty - no journal)");
+    agent::settings::add("journalSize", agent::Journal::capacity,
+                         "N (number of notifications in the journal)");
+    agent::settings::add(
+        "journalFlush",
+        [](char* line) {
+            agent::Journal::flushInterval =
+                std::chrono::seconds(strtoul(line, nullptr, 10));
+        },
+        "SEC (period of syncing the journal to storage, "
+        "0 - kernel writeback)");
+    agent::settings::add(
+        "agentxReconnect",
+        [](char* line) {
+            long min = 0;
+            long max = 0;
+            if (!agent::settings::parse(line, min) || min <= 0)
+            {
+                config_perror("delay in milliseconds expected");
+                return;
+            }
+            agent::Reconnect::minDelay = std::chrono::milliseconds(min);
+            if (agent::settings::parse(line, max))
+            {
+                agent::Reconnect::maxDelay =
+                    std::chrono::milliseconds(std::max(min, max));
+            }
+        },
+        "MIN_MS [MAX_MS] (delay before reopening AgentX session, "
+        "doubled up to MAX_MS)");
+    agent::settings::add("builtinAgentX", agent::AgentX::enabled,
+                         "1|0 (serve MIB tables by the built-in AgentX "
+                         "engine)");
+    agent::settings::add("ingestThread", data::Ingestion::enabled,
+                         "1|0 (decode DBus property changes by a separate "
+                         "thread)");
+    agent::settings::add("requestPriority", agent::Loop::requestPriority,
+                         "N (sd-event priority of SNMP requests, "
+                         "lower is first)");
+    agent::settings::add("dbusPriority", agent::Loop::dbusPriority,
+                         "N (sd-event priority of DBus messages, "
+                         "lower is first)");
+    agent::settings::add(
+        "loopLagInterval",
+        [](char* line) {
+            agent::Loop::lagInterval =
+                std::chrono::milliseconds(strtoul(line, nullptr, 10));
+        },
+        "MS (period of the event loop lag measurement, 0 - off)");
+}
+
+/** @brief Check if the agent serves SNMP requests itself */
+static bool is_master()
+{
+    return MASTER_AGENT == netsnmp_ds_get_boolean(NETSNMP_DS_APPLICATION_ID,
+                                                  NETSNMP_DS_AGENT_ROLE);
+}
+
+/** @brief Initialize snmp agent */
+bool snmpagent_init(const sdeventplus::Event& event)
+{
     // initialize tcpip, if necessary
     SOCK_STARTUP;
 
     // initialize the agent library
     init_agent(PACKAGE_NAME);
 
+    if (is_master())
+    {
+        // Standard groups (system, snmp, ...), access control and
+        // notification targets are served by net-snmp MIB modules.
+        init_mib_modules();
+    }
+
+    phosphor::snmp::agent::settings::init();
+    register_settings();
+
+    if (!is_master())
+    {
+        // net-snmp reopens the session only with fixed agentxPingInterval,
+        // the attempts are scheduled here with backoff instead.
+        snmp_reconnect = std::make_unique<phosphor::snmp::agent::Reconnect>(
+            "AgentX subagent", snmp_reopen);
+        snmp_register_callback(SNMP_CALLBACK_APPLICATION,
+                               SNMPD_CALLBACK_INDEX_START,
+                               snmp_session_changed, nullptr);
+        snmp_register_callback(SNMP_CALLBACK_APPLICATION,
+                               SNMPD_CALLBACK_INDEX_STOP,
+                               snmp_session_changed, nullptr);
+    }
+
     // We will be used to read <PACKAGE_NAME>.conf files.
     init_snmp(PACKAGE_NAME);
 
-    // This is run before the event loop will sleep and wait for new events.
-    static sdeventplus::source::Post post(
+    if (is_master())
+    {
+        // Listen on `agentaddress` of <PACKAGE_NAME>.conf, udp:161
+        // by default.
+        if (0 != init_master_agent())
+        {
+            TRACE_ERROR("Can't listen for SNMP requests\n");
+            snmp_shutdown(PACKAGE_NAME);
+            SOCK_CLEANUP;
+            return false;
+        }
+        if (phosphor::snmp::agent::AgentX::enabled)
+        {
+            TRACE_WARNING("builtinAgentX is ignored by master agent\n");
+            phosphor::snmp::agent::AgentX::enabled = false;
+        }
+        TRACE_INFO("Running as master agent\n");
+    }
+
+    phosphor::snmp::agent::Scheduler::instance().init(event);
+    phosphor::snmp::agent::Loop::instance().init(event);
+    phosphor::snmp::agent::Journal::instance().init();
+    phosphor::snmp::agent::TrapDispatcher::instance().init(event);
+    phosphor::snmp::agent::InformSender::instance().init();
+    phosphor::snmp::agent::AgentX::instance().init(event);
+
+    if (snmp_reconnect && !snmp_reconnect->connected())
+    {
+        TRACE_WARNING("AgentX master is not available\n");
+        snmp_reconnect->down();
+    }
+
+    FD_ZERO(&snmp_fdset);
+    snmp_timer = std::make_unique<Time>(event, Clock(event).now(),
+                                        std::chrono::microseconds{1},
+                                        sdevent_snmp_timeout);
+    snmp_timer->set_enabled(sdeventplus::source::Enabled::Off);
+
+    // Sessions are opened and closed, and requests are started only
+    // from net-snmp calls, so the descriptors and timeout are refreshed
+    // once after them instead of before every sleep of the event loop.
+    snmp_update = std::make_unique<sdeventplus::source::Defer>(
         event, [](sdeventplus::source::EventBase& source) {
+            source.set_enabled(sdeventplus::source::Enabled::Off);
             sdevent_snmp_update(source.get_event());
         });
 
-    sdevent_snmp_update(event);
+    // The first update is run after the MIB modules are registered.
+    snmpagent_update();
+    return true;
 }
 
 /** @brief Deinitialize snmp agen */
 void snmpagent_destroy()
 {
+    DEBUGMSGTL(("snmpagent:handle", "updates=%llu\n",
+                static_cast<unsigned long long>(snmpagent_updates())));
+
+    phosphor::snmp::agent::TrapDispatcher::instance().destroy();
+    phosphor::snmp::agent::InformSender::instance().destroy();
+    phosphor::snmp::agent::Journal::instance().destroy();
+    phosphor::snmp::agent::AgentX::instance().destroy();
+    snmp_reconnect.reset();
+    phosphor::snmp::agent::Loop::instance().destroy();
+    phosphor::snmp::agent::Scheduler::instance().destroy();
+    snmp_update.reset();
+    snmp_timer.reset();
+    snmp_fds.clear();
     snmp_shutdown(PACKAGE_NAME);
+    if (is_master())
+    {
+        shutdown_master_agent();
+    }
     SOCK_CLEANUP;
 }
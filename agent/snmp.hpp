@@ -20,7 +20,39 @@
  */
 #pragma once
 
+#include "reconnect.hpp"
+
 #include <sdeventplus/event.hpp>
 
-void snmpagent_init(const sdeventplus::Event& event);
+#include <cstdint>
+
+/**
+ * @brief Initialize net-snmp agent on the event loop.
+ *
+ * The agent runs as AgentX subagent or, if `NETSNMP_DS_AGENT_ROLE`
+ * is set to `MASTER_AGENT`, serves SNMP requests itself.
+ *
+ * @return false if the master agent can't listen for requests.
+ */
+bool snmpagent_init(const sdeventplus::Event& event);
 void snmpagent_destroy();
+
+/**
+ * @brief Schedule refresh of net-snmp descriptors and timeout.
+ *
+ * Should be called after net-snmp calls which may open or close sessions
+ * or send requests waiting for response, e.g. `send_v2trap()`.
+ */
+void snmpagent_update();
+
+/**
+ * @brief Number of refreshes of net-snmp descriptors and timeout.
+ */
+uint64_t snmpagent_updates();
+
+/**
+ * @brief Reconnection state of the AgentX subagent session.
+ *
+ * @return nullptr for master agent.
+ */
+const phosphor::snmp::agent::Reconnect* snmpagent_reconnect();
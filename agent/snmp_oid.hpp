@@ -21,8 +21,11 @@
 #pragma once
 
 #include <net-snmp/net-snmp-includes.h>
-#include <vector>
-#include <cstdarg>
+
+#include <array>
+#include <initializer_list>
+#include <stdexcept>
+#include <string_view>
 
 namespace phosphor
 {
@@ -31,52 +34,158 @@ namespace snmp
 namespace agent
 {
 
-using OID = std::vector<oid>;
-
 /**
- * @brief Parse OID present as string
+ * @brief OID of fixed capacity.
+ *
+ * Usable in constant expressions and doesn't allocate, so row OIDs
+ * can be built on the stack right when they are needed.
  *
- * @param oid_value - Container for parsed oid
- * @param fmt - Format string for oid presence
- * @param ... - Additional args for oid string
+ * @tparam Capacity - Max number of arcs
  */
-inline void make_oid(OID& oid_value, const char* fmt, ...)
+template <size_t Capacity> class FixedOID
 {
-    va_list ap;
-    std::vector<char> oid_str;
+  public:
+    static_assert(Capacity <= MAX_OID_LEN, "OID is too long");
 
-    // Calculate required size of oid_strfer
-    va_start(ap, fmt);
-    int n = vsnprintf(nullptr, 0, fmt, ap);
-    va_end(ap);
+    constexpr FixedOID() = default;
+
+    constexpr FixedOID(std::initializer_list<oid> arcs)
+    {
+        append(arcs);
+    }
 
-    if (n > 0)
+    template <size_t N> constexpr FixedOID(const FixedOID<N>& other)
     {
-        oid_str.resize(n + 1); // for terminating '\0'
+        append(other);
+    }
 
-        // Create string oid
-        va_start(ap, fmt);
-        n = vsnprintf(oid_str.data(), oid_str.size(), fmt, ap);
-        va_end(ap);
+    /**
+     * @brief Append numeric arc.
+     *
+     * @throw std::length_error if capacity is exceeded.
+     */
+    constexpr FixedOID& append(oid arc)
+    {
+        if (_length >= Capacity)
+        {
+            throw std::length_error("FixedOID: capacity exceeded");
+        }
+        _arcs[_length++] = arc;
+        return *this;
     }
 
-    if (n < 0)
+    /**
+     * @brief Append numeric arcs.
+     *
+     * @throw std::length_error if capacity is exceeded.
+     */
+    constexpr FixedOID& append(std::initializer_list<oid> arcs)
     {
-        oid_str.clear();
+        for (auto arc : arcs)
+        {
+            append(arc);
+        }
+        return *this;
     }
 
-    // Parse oid string
-    size_t oid_len = MAX_OID_LEN;
-    oid_value.resize(oid_len);
-    if (read_objid(oid_str.data(), oid_value.data(), &oid_len))
+    /**
+     * @brief Append arcs of other OID.
+     *
+     * @throw std::length_error if capacity is exceeded.
+     */
+    template <size_t N> constexpr FixedOID& append(const FixedOID<N>& other)
     {
-        oid_value.resize(oid_len);
+        for (auto arc : other)
+        {
+            append(arc);
+        }
+        return *this;
     }
-    else
+
+    /**
+     * @brief Append OCTET STRING index.
+     *
+     * @param str - Index value
+     * @param implied - IMPLIED index is not prefixed with its length
+     *
+     * @return false if there is no room for the index,
+     *         the OID stays unchanged in this case.
+     */
+    constexpr bool appendString(std::string_view str, bool implied = false)
     {
-        oid_value.clear();
+        if (str.length() + (implied ? 0 : 1) > Capacity - _length)
+        {
+            return false;
+        }
+        if (!implied)
+        {
+            _arcs[_length++] = str.length();
+        }
+        for (auto c : str)
+        {
+            _arcs[_length++] = static_cast<unsigned char>(c);
+        }
+        return true;
     }
-}
+
+    /**
+     * @brief Make a copy with appended numeric arcs.
+     *
+     * Allows to derive OIDs from the base one like `YADRO_OID(1, 2)`.
+     */
+    template <typename... Arcs>
+    constexpr FixedOID<Capacity + sizeof...(Arcs)>
+        operator()(Arcs... arcs) const
+    {
+        FixedOID<Capacity + sizeof...(Arcs)> result(*this);
+        (result.append(static_cast<oid>(arcs)), ...);
+        return result;
+    }
+
+    constexpr const oid* data() const
+    {
+        return _arcs.data();
+    }
+
+    constexpr size_t size() const
+    {
+        return _length;
+    }
+
+    constexpr bool empty() const
+    {
+        return 0 == _length;
+    }
+
+    constexpr oid operator[](size_t index) const
+    {
+        return _arcs[index];
+    }
+
+    constexpr oid back() const
+    {
+        return _arcs[_length - 1];
+    }
+
+    constexpr const oid* begin() const
+    {
+        return _arcs.data();
+    }
+
+    constexpr const oid* end() const
+    {
+        return _arcs.data() + _length;
+    }
+
+  private:
+    std::array<oid, Capacity> _arcs{};
+    size_t _length = 0;
+};
+
+/**
+ * @brief OID able to hold any valid OID.
+ */
+using OID = FixedOID<MAX_OID_LEN>;
 
 } // namespace agent
 } // namespace snmp
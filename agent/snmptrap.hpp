@@ -22,8 +22,11 @@
 
 #include <net-snmp/net-snmp-includes.h>
 #include <array>
+#include <utility>
 #include "snmp_oid.hpp"
 #include "snmpvars.hpp"
+#include "tracing.hpp"
+#include "trapdispatcher.hpp"
 
 namespace phosphor
 {
@@ -32,30 +35,6 @@ namespace snmp
 namespace agent
 {
 
-namespace details
-{
-
-/**
- * @brief unique_ptr functor to release an variable list reference.
- */
-struct VariableListDeleter
-{
-    void operator()(netsnmp_variable_list* ptr) const
-    {
-        deleter(ptr);
-    }
-
-    decltype(&snmp_free_varbind) deleter = snmp_free_varbind;
-};
-
-/**
- * @brief Alias 'VariableList' to a unique_ptr type for auto-release.
- */
-using VariableList =
-    std::unique_ptr<netsnmp_variable_list, VariableListDeleter>;
-
-} // namespace details
-
 /*
  * In the notification, we have to assign our notification OID to
  * the snmpTrapOID.0 object. Here is it's defintion.
@@ -80,7 +59,7 @@ class Trap
     Trap& operator=(Trap&&) = default;
     ~Trap() = default;
 
-    explicit Trap(const OID& trap_oid)
+    template <size_t N> explicit Trap(const FixedOID<N>& trap_oid)
     {
         create_variable_list(trap_oid.data(), trap_oid.size());
     }
@@ -90,7 +69,8 @@ class Trap
         create_variable_list(trap_oid, trap_oid_len);
     }
 
-    template <typename T> void add_field(const OID& field_oid, T&& field_value)
+    template <size_t N, typename T>
+    void add_field(const FixedOID<N>& field_oid, T&& field_value)
     {
         add_field(field_oid.data(), field_oid.size(),
                   std::forward<T>(field_value));
@@ -128,10 +108,16 @@ class Trap
                           std::forward<T>(field_value));
     }
 
-    void send() const
+    /**
+     * @brief Pass the trap to the dispatcher.
+     *
+     * The trap may be delayed or superseded by a later trap
+     * of the same row, see `TrapDispatcher`.
+     */
+    void send()
     {
         DEBUGMSGTL(("snmpagent:trap", "send trap\n"));
-        send_v2trap(_vars.get());
+        TrapDispatcher::instance().submit(std::move(_vars));
     }
 
   protected:
@@ -159,6 +145,104 @@ class Trap
     details::VariableList _vars;
 };
 
+/**
+ * @brief Trap built once and sent many times.
+ *
+ * Rows always send traps of the same shape, so the variables list
+ * and the dispatcher keys are prepared once and only the integer values
+ * are patched before sending. The list is copied only if the previous
+ * trap is still waiting in the dispatcher.
+ */
+class TrapTemplate : public Trap
+{
+  public:
+    using Trap::Trap;
+
+    /**
+     * @brief Set integer value of the field.
+     *
+     * @param index - Field index in order of `add_field()` calls
+     * @param value - New value
+     */
+    void set(size_t index, int value)
+    {
+        if (!detach())
+        {
+            // The list is held by the dispatcher, the trap is incomplete.
+            _lost = true;
+            return;
+        }
+
+        // Skip snmpTrapOID.0
+        auto var = _shared->next_variable;
+        for (; var && index > 0; --index)
+        {
+            var = var->next_variable;
+        }
+        if (var && var->type == ASN_INTEGER)
+        {
+            *var->val.integer = value;
+        }
+    }
+
+    /**
+     * @brief Set boolean value of the field.
+     */
+    void set(size_t index, bool value)
+    {
+        set(index, SNMPBOOL(value));
+    }
+
+    /**
+     * @brief Pass the trap to the dispatcher.
+     *
+     * The trap is dropped if the list could not be copied.
+     */
+    void send()
+    {
+        DEBUGMSGTL(("snmpagent:trap", "send trap template\n"));
+        if (std::exchange(_lost, false) || !detach())
+        {
+            TRACE_ERROR("Trap dropped: failed to copy variables\n");
+            return;
+        }
+        TrapDispatcher::instance().submit(details::SharedVariableList(_shared),
+                                          _keys);
+    }
+
+  private:
+    /**
+     * @brief Make the list owned only by this template.
+     *
+     * @return false if the list is not created or could not be copied,
+     *         the shared list is kept as is.
+     */
+    bool detach()
+    {
+        if (_vars)
+        {
+            // First use, fields are added already.
+            _keys = TrapDispatcher::getKeys(_vars.get());
+            _shared = std::move(_vars);
+        }
+        else if (_shared.use_count() > 1)
+        {
+            auto copy = snmp_clone_varbind(_shared.get());
+            if (!copy)
+            {
+                return false;
+            }
+            _shared.reset(copy, snmp_free_varbind);
+        }
+        return static_cast<bool>(_shared);
+    }
+
+    details::SharedVariableList _shared;
+    TrapDispatcher::Keys _keys;
+    // A value was not set since the last `send()`.
+    bool _lost = false;
+};
+
 } // namespace agent
 } // namespace snmp
 } // namespace phosphor
@@ -20,6 +20,9 @@
  */
 #pragma once
 
+#include <memory>
+#include <string>
+
 namespace phosphor
 {
 namespace snmp
@@ -27,6 +30,35 @@ namespace snmp
 namespace agent
 {
 
+namespace details
+{
+
+/**
+ * @brief unique_ptr functor to release an variable list reference.
+ */
+struct VariableListDeleter
+{
+    void operator()(netsnmp_variable_list* ptr) const
+    {
+        deleter(ptr);
+    }
+
+    decltype(&snmp_free_varbind) deleter = snmp_free_varbind;
+};
+
+/**
+ * @brief Alias 'VariableList' to a unique_ptr type for auto-release.
+ */
+using VariableList =
+    std::unique_ptr<netsnmp_variable_list, VariableListDeleter>;
+
+/**
+ * @brief Variable list shared by the trap template and the dispatcher.
+ */
+using SharedVariableList = std::shared_ptr<netsnmp_variable_list>;
+
+} // namespace details
+
 /**
  * @brief SNMP representation of boolean type.
  */
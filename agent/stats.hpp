@@ -0,0 +1,177 @@
+/**
+ * @brief Self-monitoring counters of the agent.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include "histogram.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+/**
+ * @brief Counter written by a single thread and read by any.
+ *
+ * The increment is a plain load and store, without the locked
+ * read-modify-write instruction, so it costs as much as an ordinary
+ * integer. Every counter is incremented by one thread only: the main
+ * loop or the ingestion thread.
+ */
+class Counter
+{
+  public:
+    Counter& operator+=(uint64_t value)
+    {
+        _value.store(_value.load(std::memory_order_relaxed) + value,
+                     std::memory_order_relaxed);
+        return *this;
+    }
+
+    Counter& operator++()
+    {
+        return *this += 1;
+    }
+
+    uint64_t value() const
+    {
+        return _value.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<uint64_t> _value{0};
+};
+
+/**
+ * @brief Requests and DBus signals statistics of a MIB object.
+ */
+struct ObjectStats
+{
+    using clock_t = std::chrono::steady_clock;
+
+    /**
+     * @brief Request modes, the GetBulk is served as GetNext.
+     */
+    enum Mode
+    {
+        GET = 0,
+        GETNEXT,
+        MODES
+    };
+
+    /**
+     * @brief Count the variables served since `start`.
+     *
+     * The service time of the whole batch is added to the histogram.
+     */
+    void served(Mode mode, clock_t::time_point start, size_t variables = 1)
+    {
+        requests[mode] += variables;
+        time[mode].add(clock_t::now() - start);
+    }
+
+    // MIB name, empty if the object is not served by the process.
+    std::string name;
+
+    // Served by the main loop.
+    Counter requests[MODES];
+    Histogram time[MODES];
+    size_t rows = 0;
+
+    // Received by the main loop or by the ingestion thread.
+    Counter signals;
+    Counter decoded;
+    // Updates of the objects which are not the table rows, main loop.
+    Counter ignored;
+};
+
+/**
+ * @brief Registry of the objects statistics.
+ */
+class Stats
+{
+  public:
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Copy and move operations due to the objects are
+     *           referred by their owners.
+     *     Allowed:
+     *         - Default constructor.
+     *         - Destructor.
+     */
+    Stats() = default;
+    Stats(const Stats&) = delete;
+    Stats& operator=(const Stats&) = delete;
+    Stats(Stats&&) = delete;
+    Stats& operator=(Stats&&) = delete;
+    ~Stats() = default;
+
+    /**
+     * @brief Process-wide registry.
+     */
+    static Stats& instance()
+    {
+        static Stats stats;
+        return stats;
+    }
+
+    /**
+     * @brief Add statistics of the object.
+     *
+     * @param name - MIB name, may be set later
+     *
+     * @return Statistics valid until the process exits.
+     */
+    ObjectStats& add(const std::string& name = {})
+    {
+        _objects.emplace_back();
+        _objects.back().name = name;
+        return _objects.back();
+    }
+
+    /**
+     * @brief Call the function for each object served by the process.
+     */
+    template <typename Func> void forEach(Func&& func) const
+    {
+        for (const auto& object : _objects)
+        {
+            if (!object.name.empty())
+            {
+                func(object);
+            }
+        }
+    }
+
+  private:
+    std::list<ObjectStats> _objects;
+};
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
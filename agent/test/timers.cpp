@@ -0,0 +1,139 @@
+/**
+ * @brief Correctness test of the shared timers.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "scheduler.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+using phosphor::snmp::agent::Scheduler;
+using phosphor::snmp::agent::Timer;
+
+/**
+ * @brief Timer with the expected expiration.
+ */
+struct Probe
+{
+    std::unique_ptr<Timer> timer;
+    Scheduler::clock_t::time_point deadline;
+    Scheduler::clock_t::time_point fired;
+    bool cancelled = false;
+    size_t starts = 0;
+    size_t fires = 0;
+};
+
+int main(int argc, char* argv[])
+{
+    size_t count = argc > 1 ? strtoul(argv[1], nullptr, 0) : 2000;
+
+    auto event = sdeventplus::Event::get_new();
+    auto& scheduler = Scheduler::instance();
+    scheduler.init(event);
+    Scheduler::clock_t clock(event);
+
+    // Level 0 and 1 timeouts, upper levels take too long to wait for.
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> timeouts(0, 1500);
+    auto start = [&](Probe& probe, std::chrono::milliseconds timeout) {
+        probe.deadline = clock.now() + timeout;
+        probe.timer->start(timeout);
+        ++probe.starts;
+    };
+
+    std::vector<Probe> probes(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto& probe = probes[i];
+        probe.timer = std::make_unique<Timer>([&, i]() {
+            auto& probe = probes[i];
+            probe.fired = clock.now();
+            ++probe.fires;
+            // Restarted from the callback once.
+            if (i % 7 == 0 && probe.starts < 2)
+            {
+                start(probe, std::chrono::milliseconds{timeouts(random)});
+            }
+        });
+        start(probe, std::chrono::milliseconds{timeouts(random)});
+    }
+
+    // Timers of the upper levels are linked and unlinked only.
+    Timer minutes([]() {});
+    Timer days([]() {});
+    minutes.start(std::chrono::minutes{2});
+    days.start(std::chrono::hours{24 * 10});
+    minutes.stop();
+    days.stop();
+
+    size_t running = count;
+    for (size_t i = 3; i < count; i += 11)
+    {
+        probes[i].timer->stop();
+        probes[i].cancelled = true;
+        --running;
+    }
+    if (scheduler.size() != running)
+    {
+        printf("FAIL: %zu timers running, %zu expected\n", scheduler.size(),
+               running);
+        return EXIT_FAILURE;
+    }
+
+    auto limit = std::chrono::steady_clock::now() + std::chrono::seconds{10};
+    while (scheduler.size() && std::chrono::steady_clock::now() < limit)
+    {
+        event.run(std::chrono::milliseconds{100});
+    }
+
+    size_t failed = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& probe = probes[i];
+        const char* error = nullptr;
+        if (probe.cancelled)
+        {
+            error = probe.fires ? "cancelled timer fired" : nullptr;
+        }
+        else if (probe.fires != probe.starts)
+        {
+            error = "timer did not fire";
+        }
+        else if (probe.fired < probe.deadline)
+        {
+            error = "timer fired early";
+        }
+
+        if (error && failed++ < 10)
+        {
+            printf("FAIL: timer %zu: %s\n", i, error);
+        }
+    }
+
+    printf("%zu timers, %llu fired, %zu failed\n", count,
+           static_cast<unsigned long long>(scheduler.fired()), failed);
+
+    probes.clear();
+    scheduler.destroy();
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,363 @@
+/**
+ * @brief SNMP traps rate limiter implementation.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "tracing.hpp"
+#include "trapdispatcher.hpp"
+#include "informsender.hpp"
+#include "journal.hpp"
+#include "snmp.hpp"
+
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+#include <systemd/sd-event.h>
+
+#include <algorithm>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+/**
+ * @brief Make map key of the OID.
+ */
+static std::string makeKey(const oid* name, size_t len)
+{
+    return std::string(reinterpret_cast<const char*>(name), len * sizeof(oid));
+}
+
+bool TrapDispatcher::Bucket::ready(const Limit& limit, clock_t::time_point now)
+{
+    if (limit.rate <= 0)
+    {
+        return true;
+    }
+
+    if (tokens < 0)
+    {
+        tokens = limit.burst;
+    }
+    else
+    {
+        std::chrono::duration<double> elapsed = now - updated;
+        tokens = std::min(limit.burst, tokens + elapsed.count() * limit.rate);
+    }
+    updated = now;
+
+    return tokens >= 1.;
+}
+
+void TrapDispatcher::Bucket::take(const Limit& limit)
+{
+    if (limit.rate > 0)
+    {
+        tokens -= 1.;
+    }
+}
+
+TrapDispatcher::clock_t::duration
+    TrapDispatcher::Bucket::wait(const Limit& limit) const
+{
+    if (limit.rate <= 0 || tokens >= 1.)
+    {
+        return clock_t::duration::zero();
+    }
+
+    return std::chrono::duration_cast<clock_t::duration>(
+        std::chrono::duration<double>((1. - tokens) / limit.rate));
+}
+
+bool TrapDispatcher::Bucket::full(const Limit& limit,
+                                  clock_t::time_point now) const
+{
+    if (limit.rate <= 0 || tokens < 0)
+    {
+        return true;
+    }
+
+    std::chrono::duration<double> elapsed = now - updated;
+    return tokens + elapsed.count() * limit.rate >= limit.burst;
+}
+
+TrapDispatcher& TrapDispatcher::instance()
+{
+    static TrapDispatcher dispatcher;
+    return dispatcher;
+}
+
+void TrapDispatcher::init(const sdeventplus::Event& event)
+{
+    _event.emplace(event);
+    _timer = std::make_unique<Time>(
+        event, sdeventplus::Clock<sdeventplus::ClockId::Monotonic>(event).now(),
+        std::chrono::milliseconds{1}, [this](Time&, Time::TimePoint) {
+            DEBUGMSGTL(("snmpagent:trap", "Send delayed traps\n"));
+            flush();
+        });
+    _timer->set_enabled(sdeventplus::source::Enabled::Off);
+
+    // Lower priority than DBus, so signals are handled first.
+    _sender = std::make_unique<sdeventplus::source::Defer>(
+        event, [this](sdeventplus::source::EventBase&) { drain(); });
+    _sender->set_priority(SD_EVENT_PRIORITY_IDLE);
+    _sender->set_enabled(sdeventplus::source::Enabled::Off);
+}
+
+void TrapDispatcher::destroy()
+{
+    _dropped += _pending.size();
+    _pendingRows.clear();
+    _pending.clear();
+    _timer.reset();
+
+    while (!_queue.empty())
+    {
+        send_v2trap(_queue.front().get());
+        _queue.pop_front();
+        ++_sent;
+    }
+    _sender.reset();
+    _event.reset();
+
+    DEBUGMSGTL(("snmpagent:trap",
+                "submitted=%llu, sent=%llu, delayed=%llu, superseded=%llu, "
+                "dropped=%llu, suppressed=%llu, maxQueued=%zu, "
+                "overflowed=%llu\n",
+                static_cast<unsigned long long>(_submitted),
+                static_cast<unsigned long long>(_sent),
+                static_cast<unsigned long long>(_delayed),
+                static_cast<unsigned long long>(_coalesced),
+                static_cast<unsigned long long>(_dropped),
+                static_cast<unsigned long long>(_suppressed), _maxQueued,
+                static_cast<unsigned long long>(_overflowed)));
+}
+
+TrapDispatcher::Keys
+    TrapDispatcher::getKeys(const netsnmp_variable_list* vars)
+{
+    // The first variable is snmpTrapOID.0 with the notification OID.
+    auto notifyKey = makeKey(vars->val.objid, vars->val_len / sizeof(oid));
+    auto field = vars->next_variable;
+    auto rowKey = field ? makeKey(field->name, field->name_length) : notifyKey;
+    return {std::move(notifyKey), std::move(rowKey)};
+}
+
+void TrapDispatcher::submit(details::SharedVariableList&& vars,
+                            const Keys& keys)
+{
+    ++_submitted;
+
+    if (_muted)
+    {
+        ++_suppressed;
+        DEBUGMSGTL(("snmpagent:trap", "Trap suppressed\n"));
+        return;
+    }
+
+    // Journal keeps all notifications, even delayed and superseded ones.
+    Journal::instance().append(vars.get());
+
+    auto it = _pendingRows.find(keys.row);
+    if (it != _pendingRows.end())
+    {
+        // Replace the delayed trap of the row keeping its place in queue.
+        it->second->notifyKey = keys.notify;
+        it->second->vars = std::move(vars);
+        ++_coalesced;
+        DEBUGMSGTL(("snmpagent:trap", "Delayed trap superseded\n"));
+        return;
+    }
+
+    if (trySend(keys.notify, keys.row, vars, clock_t::now()))
+    {
+        return;
+    }
+
+    if (!_timer)
+    {
+        ++_dropped;
+        TRACE_WARNING("Trap dropped: rate limit exceeded\n");
+        return;
+    }
+
+    if (_pending.empty())
+    {
+        _burstCoalesced = _coalesced;
+        TRACE_NOTICE("Trap rate limit exceeded, traps are delayed\n");
+    }
+
+    ++_delayed;
+    DEBUGMSGTL(("snmpagent:trap", "Trap delayed, %zu pending\n",
+                _pending.size() + 1));
+    _pending.push_back({keys.notify, keys.row, std::move(vars)});
+    _pendingRows.emplace(keys.row, std::prev(_pending.end()));
+
+    if (1 == _pending.size())
+    {
+        flush();
+    }
+}
+
+void TrapDispatcher::sweep(clock_t::time_point now)
+{
+    if (now - _swept < sweepInterval)
+    {
+        return;
+    }
+    _swept = now;
+
+    auto erase = [now](auto& buckets, const Limit& limit) {
+        for (auto it = buckets.begin(); it != buckets.end();)
+        {
+            it = it->second.full(limit, now) ? buckets.erase(it) : ++it;
+        }
+    };
+    erase(_notifyBuckets, notifyLimit);
+    erase(_rowBuckets, rowLimit);
+    DEBUGMSGTL(("snmpagent:trap", "%zu notification and %zu row buckets\n",
+                _notifyBuckets.size(), _rowBuckets.size()));
+}
+
+bool TrapDispatcher::trySend(const std::string& notifyKey,
+                             const std::string& rowKey,
+                             details::SharedVariableList& vars,
+                             clock_t::time_point now)
+{
+    sweep(now);
+
+    auto& notifyBucket = _notifyBuckets[notifyKey];
+    auto& rowBucket = _rowBuckets[rowKey];
+
+    if (!notifyBucket.ready(notifyLimit, now) ||
+        !rowBucket.ready(rowLimit, now))
+    {
+        return false;
+    }
+
+    notifyBucket.take(notifyLimit);
+    rowBucket.take(rowLimit);
+
+    InformSender::instance().submit(vars, rowKey);
+    enqueue(std::move(vars));
+    return true;
+}
+
+void TrapDispatcher::enqueue(details::SharedVariableList&& vars)
+{
+    if (!_sender)
+    {
+        send_v2trap(vars.get());
+        ++_sent;
+        snmpagent_update();
+        return;
+    }
+
+    if (_queue.size() >= std::max<size_t>(queueSize, 1))
+    {
+        ++_overflowed;
+        if (!_overflow)
+        {
+            _overflow = true;
+            TRACE_WARNING("Trap send queue is full, %s traps are dropped\n",
+                          queueOverflow == Overflow::DropOldest ? "oldest"
+                                                                : "newest");
+        }
+        if (queueOverflow == Overflow::DropNewest)
+        {
+            return;
+        }
+        _queue.pop_front();
+    }
+
+    _queue.emplace_back(std::move(vars));
+    _maxQueued = std::max(_maxQueued, _queue.size());
+    _sender->set_enabled(sdeventplus::source::Enabled::OneShot);
+}
+
+void TrapDispatcher::drain()
+{
+    auto batch = std::max<size_t>(queueBatch, 1);
+    DEBUGMSGTL(("snmpagent:trap", "Send up to %zu of %zu queued traps\n",
+                batch, _queue.size()));
+
+    for (; batch > 0 && !_queue.empty(); --batch)
+    {
+        send_v2trap(_queue.front().get());
+        _queue.pop_front();
+        ++_sent;
+    }
+    snmpagent_update();
+
+    if (!_queue.empty())
+    {
+        _sender->set_enabled(sdeventplus::source::Enabled::OneShot);
+    }
+    else
+    {
+        _overflow = false;
+    }
+}
+
+void TrapDispatcher::flush()
+{
+    auto now = clock_t::now();
+    std::optional<clock_t::duration> next;
+
+    for (auto it = _pending.begin(); it != _pending.end();)
+    {
+        if (trySend(it->notifyKey, it->rowKey, it->vars, now))
+        {
+            _pendingRows.erase(it->rowKey);
+            it = _pending.erase(it);
+            continue;
+        }
+
+        auto wait = std::max(_notifyBuckets[it->notifyKey].wait(notifyLimit),
+                             _rowBuckets[it->rowKey].wait(rowLimit));
+        if (!next || wait < *next)
+        {
+            next = wait;
+        }
+        ++it;
+    }
+
+    if (next)
+    {
+        auto timeout = std::max(
+            std::chrono::duration_cast<std::chrono::microseconds>(*next),
+            std::chrono::microseconds{1000});
+        _timer->set_time(
+            sdeventplus::Clock<sdeventplus::ClockId::Monotonic>(*_event)
+                .now() +
+            timeout);
+        _timer->set_enabled(sdeventplus::source::Enabled::OneShot);
+    }
+    else
+    {
+        TRACE_NOTICE("Delayed traps sent, %llu superseded by later ones\n",
+                     static_cast<unsigned long long>(_coalesced -
+                                                     _burstCoalesced));
+    }
+}
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
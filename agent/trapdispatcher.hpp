@@ -0,0 +1,353 @@
+/**
+ * @brief SNMP traps rate limiter.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+
+#include "snmpvars.hpp"
+
+#include <sdeventplus/clock.hpp>
+#include <sdeventplus/event.hpp>
+#include <sdeventplus/source/event.hpp>
+#include <sdeventplus/source/time.hpp>
+
+#include <chrono>
+#include <deque>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace phosphor
+{
+namespace snmp
+{
+namespace agent
+{
+
+/**
+ * @brief Dispatcher of the outgoing traps.
+ *
+ * Traps are limited by token buckets per notification OID and per row.
+ * The row is identified by OID of the first trap variable.
+ * Traps over the limit are delayed, and a delayed trap is replaced
+ * by the next trap of the same row, so only the latest state of the row
+ * is sent after a burst.
+ *
+ * Traps allowed by the limits are put into a bounded queue, which is
+ * drained by a low priority event source, so encoding and sending of PDUs
+ * never happen inside DBus signal handlers.
+ */
+class TrapDispatcher
+{
+  public:
+    using clock_t = std::chrono::steady_clock;
+
+    /**
+     * @brief Token bucket parameters.
+     */
+    struct Limit
+    {
+        double rate;  // Tokens per second, 0 - unlimited.
+        double burst; // Bucket capacity.
+    };
+
+    /**
+     * @brief Limit of traps for each notification OID.
+     */
+    inline static Limit notifyLimit = {10., 30.};
+
+    /**
+     * @brief Limit of traps for each row.
+     */
+    inline static Limit rowLimit = {1., 2.};
+
+    /**
+     * @brief Suppress traps during the initial population.
+     *
+     * The owner of the gate sends a summary notification instead.
+     */
+    inline static bool startupMode = true;
+
+    /**
+     * @brief What to drop when the send queue is full.
+     */
+    enum class Overflow
+    {
+        DropOldest,
+        DropNewest,
+    };
+
+    /**
+     * @brief Max number of traps in the send queue.
+     */
+    inline static size_t queueSize = 256;
+
+    /**
+     * @brief Max number of traps sent per event loop iteration.
+     */
+    inline static size_t queueBatch = 16;
+
+    /**
+     * @brief Send queue overflow policy.
+     */
+    inline static Overflow queueOverflow = Overflow::DropOldest;
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Copy and move operations due to singleton.
+     *     Allowed:
+     *         - Default constructor.
+     *         - Destructor.
+     */
+    TrapDispatcher() = default;
+    TrapDispatcher(const TrapDispatcher&) = delete;
+    TrapDispatcher& operator=(const TrapDispatcher&) = delete;
+    TrapDispatcher(TrapDispatcher&&) = delete;
+    TrapDispatcher& operator=(TrapDispatcher&&) = delete;
+    ~TrapDispatcher() = default;
+
+    /**
+     * @brief Process-wide dispatcher.
+     */
+    static TrapDispatcher& instance();
+
+    /**
+     * @brief Attach to the event loop for sending delayed traps.
+     *
+     * Until this is called traps are sent immediately
+     * and traps over the limit are dropped.
+     */
+    void init(const sdeventplus::Event& event);
+
+    /**
+     * @brief Send queued traps, release delayed traps and event sources.
+     */
+    void destroy();
+
+    /**
+     * @brief Keys of the trap buckets.
+     */
+    struct Keys
+    {
+        std::string notify; // Notification OID
+        std::string row;    // OID of the first trap variable
+    };
+
+    /**
+     * @brief Get keys of the trap buckets.
+     *
+     * @param vars - Trap variables, starting with snmpTrapOID.0
+     */
+    static Keys getKeys(const netsnmp_variable_list* vars);
+
+    /**
+     * @brief Send the trap or delay it if limit is exceeded.
+     *
+     * @param vars - Trap variables, starting with snmpTrapOID.0
+     */
+    void submit(details::SharedVariableList&& vars)
+    {
+        if (vars)
+        {
+            submit(std::move(vars), getKeys(vars.get()));
+        }
+    }
+
+    /**
+     * @brief Send the trap with precomputed keys.
+     *
+     * The variables must not be changed while the dispatcher holds them.
+     *
+     * @param vars - Trap variables, starting with snmpTrapOID.0
+     * @param keys - Keys returned by `getKeys()` for these variables
+     */
+    void submit(details::SharedVariableList&& vars, const Keys& keys);
+
+    /**
+     * @brief Discard all submitted traps until `unmute()`.
+     */
+    void mute()
+    {
+        _muted = true;
+    }
+
+    /**
+     * @brief Resume sending of submitted traps.
+     */
+    void unmute()
+    {
+        _muted = false;
+    }
+
+    /** @brief Number of traps discarded while muted. */
+    uint64_t suppressed() const
+    {
+        return _suppressed;
+    }
+
+    /** @brief Number of submitted traps. */
+    uint64_t submitted() const
+    {
+        return _submitted;
+    }
+
+    /** @brief Number of sent traps. */
+    uint64_t sent() const
+    {
+        return _sent;
+    }
+
+    /** @brief Number of traps delayed due to the limits. */
+    uint64_t delayed() const
+    {
+        return _delayed;
+    }
+
+    /** @brief Number of delayed traps superseded by later ones. */
+    uint64_t coalesced() const
+    {
+        return _coalesced;
+    }
+
+    /** @brief Number of traps dropped without the event loop. */
+    uint64_t dropped() const
+    {
+        return _dropped;
+    }
+
+    /** @brief Number of traps waiting for the limits. */
+    size_t pending() const
+    {
+        return _pending.size();
+    }
+
+    /** @brief Number of traps in the send queue. */
+    size_t queued() const
+    {
+        return _queue.size();
+    }
+
+    /** @brief Max number of traps observed in the send queue. */
+    size_t maxQueued() const
+    {
+        return _maxQueued;
+    }
+
+    /** @brief Number of traps dropped due to the send queue overflow. */
+    uint64_t overflowed() const
+    {
+        return _overflowed;
+    }
+
+  private:
+    /**
+     * @brief Token bucket state.
+     */
+    struct Bucket
+    {
+        double tokens = -1.; // Negative means not initialized yet.
+        clock_t::time_point updated;
+
+        /** @brief Refill and check for available token. */
+        bool ready(const Limit& limit, clock_t::time_point now);
+
+        /** @brief Take a token, `ready()` should be checked before. */
+        void take(const Limit& limit);
+
+        /** @brief Time until the token will be available. */
+        clock_t::duration wait(const Limit& limit) const;
+
+        /** @brief Check if the bucket is refilled up to the capacity. */
+        bool full(const Limit& limit, clock_t::time_point now) const;
+    };
+
+    /**
+     * @brief Delayed trap.
+     */
+    struct Pending
+    {
+        std::string notifyKey;
+        std::string rowKey;
+        details::SharedVariableList vars;
+    };
+
+    /**
+     * @brief Erase full buckets, they are the same as new ones.
+     *
+     * Done once per `sweepInterval`, so the maps don't grow with every
+     * notification and row ever seen.
+     */
+    void sweep(clock_t::time_point now);
+
+    /** @brief Queue the trap if both buckets have tokens. */
+    bool trySend(const std::string& notifyKey, const std::string& rowKey,
+                 details::SharedVariableList& vars, clock_t::time_point now);
+
+    /** @brief Queue delayed traps allowed by limits and re-arm the timer. */
+    void flush();
+
+    /** @brief Put the trap into the send queue. */
+    void enqueue(details::SharedVariableList&& vars);
+
+    /** @brief Send a batch of queued traps. */
+    void drain();
+
+    using Time = sdeventplus::source::Time<sdeventplus::ClockId::Monotonic>;
+
+    static constexpr auto sweepInterval = std::chrono::seconds{60};
+
+    std::optional<sdeventplus::Event> _event;
+    std::unique_ptr<Time> _timer;
+    std::unique_ptr<sdeventplus::source::Defer> _sender;
+
+    std::unordered_map<std::string, Bucket> _notifyBuckets;
+    std::unordered_map<std::string, Bucket> _rowBuckets;
+    clock_t::time_point _swept;
+
+    // Delayed traps in order of arrival, one per row.
+    std::list<Pending> _pending;
+    std::unordered_map<std::string, std::list<Pending>::iterator> _pendingRows;
+
+    // Traps allowed by the limits waiting for the sender.
+    std::deque<details::SharedVariableList> _queue;
+    size_t _maxQueued = 0;
+    // The queue was full since it was empty last time.
+    bool _overflow = false;
+
+    uint64_t _submitted = 0;
+    uint64_t _sent = 0;
+    uint64_t _delayed = 0;
+    uint64_t _coalesced = 0;
+    uint64_t _dropped = 0;
+    uint64_t _suppressed = 0;
+    uint64_t _overflowed = 0;
+    bool _muted = false;
+    // Value of `_coalesced` at the start of the current burst.
+    uint64_t _burstCoalesced = 0;
+};
+
+} // namespace agent
+} // namespace snmp
+} // namespace phosphor
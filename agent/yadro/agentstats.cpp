@@ -0,0 +1,412 @@
+/**
+ * @brief YADRO agent self-monitoring subtree implementation.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "tracing.hpp"
+#include "agentx.hpp"
+#include "loop.hpp"
+#include "stats.hpp"
+#include "trapdispatcher.hpp"
+#include "yadro/agentstats.hpp"
+#include "yadro/yadro_oid.hpp"
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <functional>
+#include <vector>
+
+namespace yadro
+{
+namespace agentstats
+{
+
+using phosphor::snmp::agent::Histogram;
+using phosphor::snmp::agent::ObjectStats;
+
+constexpr auto statsOid = YADRO_OID(10, 2);
+
+// yadroAgentGeneral scalars
+enum Scalars
+{
+    YADROAGENT_TRAPS_SUBMITTED = 1,
+    YADROAGENT_TRAPS_SENT,
+    YADROAGENT_TRAPS_SUPPRESSED,
+    YADROAGENT_TRAPS_DELAYED,
+    YADROAGENT_TRAPS_SUPERSEDED,
+    YADROAGENT_TRAPS_DROPPED,
+    YADROAGENT_TRAPS_OVERFLOWED,
+    YADROAGENT_LOOP_LAG_SAMPLES,
+    YADROAGENT_LOOP_LAG_AVERAGE,
+    YADROAGENT_LOOP_LAG_P99,
+    YADROAGENT_LOOP_LAG_MAX,
+    YADROAGENT_RSS,
+};
+
+// yadroAgentObjectTable columns
+enum ObjectColumns
+{
+    COLUMN_YADROAGENTOBJECT_NAME = 1,
+    COLUMN_YADROAGENTOBJECT_GETS,
+    COLUMN_YADROAGENTOBJECT_GETNEXTS,
+    COLUMN_YADROAGENTOBJECT_SIGNALS,
+    COLUMN_YADROAGENTOBJECT_DECODED,
+    COLUMN_YADROAGENTOBJECT_IGNORED,
+    COLUMN_YADROAGENTOBJECT_ROWS,
+};
+
+// yadroAgentLatencyTable columns
+enum LatencyColumns
+{
+    COLUMN_YADROAGENTLATENCY_BOUND = 1,
+    COLUMN_YADROAGENTLATENCY_COUNT,
+};
+
+static void setCounter64(netsnmp_variable_list* var, uint64_t value)
+{
+    counter64 c64;
+    c64.high = value >> 32;
+    c64.low = value & 0xffffffff;
+    snmp_set_var_typed_value(var, ASN_COUNTER64, &c64, sizeof(c64));
+}
+
+static void setGauge(netsnmp_variable_list* var, uint64_t value)
+{
+    snmp_set_var_typed_integer(var, ASN_GAUGE,
+                               std::min<uint64_t>(value, UINT32_MAX));
+}
+
+/**
+ * @brief Resident set size of the process in KiB.
+ */
+static uint64_t residentSize()
+{
+    unsigned long pages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm)
+    {
+        if (1 != fscanf(statm, "%*u %lu", &pages))
+        {
+            pages = 0;
+        }
+        fclose(statm);
+    }
+    return static_cast<uint64_t>(pages) * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+/**
+ * @brief The subtree served from the list of instances.
+ *
+ * The objects are known after all modules are initialized, so the
+ * instances are built once and kept in order of their OIDs.
+ */
+class StatsSubtree : public phosphor::snmp::agent::Subtree
+{
+  public:
+    using getter_t = std::function<void(netsnmp_variable_list*)>;
+
+    StatsSubtree()
+    {
+        _root.assign(statsOid.begin(), statsOid.end());
+    }
+
+    /**
+     * @brief Build the list of instances.
+     */
+    void build()
+    {
+        using phosphor::snmp::agent::Loop;
+        using phosphor::snmp::agent::TrapDispatcher;
+
+        _instances.clear();
+
+        using counter_t = uint64_t (TrapDispatcher::*)() const;
+        auto traps = [this](Scalars scalar, counter_t get) {
+            addScalar(scalar, [get](netsnmp_variable_list* var) {
+                setCounter64(var, (TrapDispatcher::instance().*get)());
+            });
+        };
+        traps(YADROAGENT_TRAPS_SUBMITTED, &TrapDispatcher::submitted);
+        traps(YADROAGENT_TRAPS_SENT, &TrapDispatcher::sent);
+        traps(YADROAGENT_TRAPS_SUPPRESSED, &TrapDispatcher::suppressed);
+        traps(YADROAGENT_TRAPS_DELAYED, &TrapDispatcher::delayed);
+        traps(YADROAGENT_TRAPS_SUPERSEDED, &TrapDispatcher::coalesced);
+        traps(YADROAGENT_TRAPS_DROPPED, &TrapDispatcher::dropped);
+        traps(YADROAGENT_TRAPS_OVERFLOWED, &TrapDispatcher::overflowed);
+
+        const auto& lag = Loop::instance().lag();
+        addScalar(YADROAGENT_LOOP_LAG_SAMPLES,
+                  [&lag](netsnmp_variable_list* var) {
+                      setCounter64(var, lag.count());
+                  });
+        addScalar(YADROAGENT_LOOP_LAG_AVERAGE,
+                  [&lag](netsnmp_variable_list* var) {
+                      setGauge(var, lag.average().count());
+                  });
+        addScalar(YADROAGENT_LOOP_LAG_P99, [&lag](netsnmp_variable_list* var) {
+            setGauge(var, lag.percentile(99).count());
+        });
+        addScalar(YADROAGENT_LOOP_LAG_MAX, [&lag](netsnmp_variable_list* var) {
+            setGauge(var, lag.max().count());
+        });
+        addScalar(YADROAGENT_RSS, [](netsnmp_variable_list* var) {
+            setGauge(var, residentSize());
+        });
+
+        phosphor::snmp::agent::Stats::instance().forEach(
+            [this](const ObjectStats& object) { addObject(object); });
+
+        std::sort(_instances.begin(), _instances.end(),
+                  [](const Instance& a, const Instance& b) {
+                      return snmp_oid_compare(a.name.data(), a.name.size(),
+                                              b.name.data(),
+                                              b.name.size()) < 0;
+                  });
+    }
+
+    bool get(const oid* name, size_t length,
+             netsnmp_variable_list* var) const override
+    {
+        auto it = lowerBound(name, length, true);
+        if (it == _instances.end() ||
+            0 != snmp_oid_compare(it->name.data(), it->name.size(), name,
+                                  length))
+        {
+            return false;
+        }
+        it->get(var);
+        return true;
+    }
+
+    bool next(const oid* name, size_t length, bool include,
+              netsnmp_variable_list* var) const override
+    {
+        auto it = lowerBound(name, length, include);
+        if (it == _instances.end())
+        {
+            return false;
+        }
+        snmp_set_var_objid(var, it->name.data(), it->name.size());
+        it->get(var);
+        return true;
+    }
+
+  private:
+    struct Instance
+    {
+        std::vector<oid> name;
+        getter_t get;
+    };
+
+    using Instances = std::vector<Instance>;
+
+    /**
+     * @brief Find the first instance following the OID.
+     */
+    Instances::const_iterator lowerBound(const oid* name, size_t length,
+                                         bool include) const
+    {
+        return std::partition_point(
+            _instances.begin(), _instances.end(),
+            [name, length, include](const Instance& instance) {
+                int cmp = snmp_oid_compare(instance.name.data(),
+                                           instance.name.size(), name, length);
+                return include ? cmp < 0 : cmp <= 0;
+            });
+    }
+
+    /**
+     * @brief Add `yadroAgentGeneral.N.0` instance.
+     */
+    void addScalar(Scalars scalar, getter_t&& get)
+    {
+        add({1, static_cast<oid>(scalar), 0}, std::move(get));
+    }
+
+    /**
+     * @brief Add rows of the object to the tables.
+     *
+     * The rows are indexed by the MIB name of the object, the latency
+     * rows also by the request mode and the histogram bucket.
+     */
+    void addObject(const ObjectStats& object)
+    {
+        std::vector<oid> index;
+        index.push_back(object.name.length());
+        for (unsigned char c : object.name)
+        {
+            index.push_back(c);
+        }
+
+        auto column = [&index](oid table, oid column) {
+            std::vector<oid> name = {table, 1, column};
+            name.insert(name.end(), index.begin(), index.end());
+            return name;
+        };
+        auto counter = [](const phosphor::snmp::agent::Counter& c) {
+            return [&c](netsnmp_variable_list* var) {
+                setCounter64(var, c.value());
+            };
+        };
+
+        add(column(2, COLUMN_YADROAGENTOBJECT_NAME),
+            [&object](netsnmp_variable_list* var) {
+                snmp_set_var_typed_value(var, ASN_OCTET_STR,
+                                         object.name.c_str(),
+                                         object.name.length());
+            });
+        add(column(2, COLUMN_YADROAGENTOBJECT_GETS),
+            counter(object.requests[ObjectStats::GET]));
+        add(column(2, COLUMN_YADROAGENTOBJECT_GETNEXTS),
+            counter(object.requests[ObjectStats::GETNEXT]));
+        add(column(2, COLUMN_YADROAGENTOBJECT_SIGNALS),
+            counter(object.signals));
+        add(column(2, COLUMN_YADROAGENTOBJECT_DECODED),
+            counter(object.decoded));
+        add(column(2, COLUMN_YADROAGENTOBJECT_IGNORED),
+            counter(object.ignored));
+        add(column(2, COLUMN_YADROAGENTOBJECT_ROWS),
+            [&object](netsnmp_variable_list* var) {
+                setGauge(var, object.rows);
+            });
+
+        for (size_t mode = 0; mode < ObjectStats::MODES; ++mode)
+        {
+            const auto& histogram = object.time[mode];
+            for (size_t bucket = 0; bucket < Histogram::buckets; ++bucket)
+            {
+                // The modes and the buckets are numbered from 1.
+                auto bound = column(3, COLUMN_YADROAGENTLATENCY_BOUND);
+                bound.push_back(mode + 1);
+                bound.push_back(bucket + 1);
+                add(std::vector<oid>(bound),
+                    [bucket](netsnmp_variable_list* var) {
+                        // The last bucket has no bound.
+                        snmp_set_var_typed_integer(
+                            var, ASN_UNSIGNED,
+                            bucket + 1 < Histogram::buckets
+                                ? Histogram::bound(bucket).count()
+                                : 0);
+                    });
+
+                bound[2] = COLUMN_YADROAGENTLATENCY_COUNT;
+                add(std::move(bound),
+                    [&histogram, bucket](netsnmp_variable_list* var) {
+                        setCounter64(var, histogram.count(bucket));
+                    });
+            }
+        }
+    }
+
+    /**
+     * @brief Add instance by OID relative to the subtree.
+     */
+    void add(std::vector<oid>&& suffix, getter_t&& get)
+    {
+        Instance instance{_root, std::move(get)};
+        instance.name.insert(instance.name.end(), suffix.begin(),
+                             suffix.end());
+        if (instance.name.size() <= MAX_OID_LEN)
+        {
+            _instances.push_back(std::move(instance));
+        }
+    }
+
+    Instances _instances;
+};
+
+static StatsSubtree subtree;
+
+/**
+ * @brief Handler for snmp requests.
+ */
+static int AgentStats_snmp_handler(netsnmp_mib_handler* /*handler*/,
+                                   netsnmp_handler_registration* /*reginfo*/,
+                                   netsnmp_agent_request_info* reqinfo,
+                                   netsnmp_request_info* requests)
+{
+    for (auto request = requests; request; request = request->next)
+    {
+        if (request->processed)
+        {
+            continue;
+        }
+
+        auto var = request->requestvb;
+        switch (reqinfo->mode)
+        {
+            case MODE_GET:
+                if (!subtree.get(var->name, var->name_length, var))
+                {
+                    netsnmp_set_request_error(reqinfo, request,
+                                              SNMP_NOSUCHINSTANCE);
+                }
+                break;
+
+            case MODE_GETNEXT:
+                // Leave request unanswered at the end of subtree,
+                // the agent continues with the next one.
+                subtree.next(var->name, var->name_length,
+                             request->inclusive, var);
+                break;
+        }
+    }
+
+    return SNMP_ERR_NOERROR;
+}
+
+/**
+ * @brief Initialize agent statistics subtree.
+ *
+ * Called after the other modules, so all served objects are known.
+ */
+void init()
+{
+    DEBUGMSGTL(("yadro:init", "Initialize yadroAgentStats\n"));
+
+    subtree.build();
+
+    if (phosphor::snmp::agent::AgentX::enabled)
+    {
+        phosphor::snmp::agent::AgentX::instance().add(&subtree);
+        return;
+    }
+
+    netsnmp_register_handler(netsnmp_create_handler_registration(
+        "yadroAgentStats", AgentStats_snmp_handler, statsOid.data(),
+        statsOid.size(), HANDLER_CAN_RONLY));
+}
+
+/**
+ * @brief Deinitialize agent statistics subtree.
+ */
+void destroy()
+{
+    DEBUGMSGTL(("yadro:shutdown", "Deinitialize yadroAgentStats\n"));
+    unregister_mib(const_cast<oid*>(statsOid.data()), statsOid.size());
+}
+
+} // namespace agentstats
+} // namespace yadro
@@ -22,15 +22,19 @@
 #include "tracing.hpp"
 #include "data/table.hpp"
 #include "data/table/item.hpp"
+#include "yadro/startup.hpp"
 #include "yadro/yadro_oid.hpp"
 #include "snmptrap.hpp"
 
+#include <optional>
+
 namespace yadro
 {
 namespace inventory
 {
 using OID = phosphor::snmp::agent::OID;
-static const OID NOTIFY_OID = YADRO_OID(0, 7);
+constexpr auto NOTIFY_OID = YADRO_OID(0, 7);
+constexpr auto inventoryTableOid = YADRO_OID(4);
 
 struct InventoryItem : public phosphor::snmp::data::table::Item<
                            std::string, std::string, std::string, std::string,
@@ -50,6 +54,11 @@ struct InventoryItem : public phosphor::snmp::data::table::Item<
         FIELD_INVENTORY_FUNCTIONAL,
     };
 
+    // DBus properties in order of fields
+    static constexpr schema_t schema = phosphor::snmp::data::table::makeSchema(
+        "PrettyName", "Manufacturer", "BuildDate", "Model", "PartNumber",
+        "SerialNumber", "Version", "Present", "Functional");
+
     enum Columns
     {
         COLUMN_YADROINVENTORY_PATH = 1,
@@ -79,28 +88,14 @@ struct InventoryItem : public phosphor::snmp::data::table::Item<
             false, // Present
             false) // Functional
     {
-        phosphor::snmp::agent::make_oid(
-            _presentOid, ".1.3.6.1.4.1.49769.4.1.%lu.\"%s\"",
-            COLUMN_YADROINVENTORY_PRESENT, name.c_str());
-        phosphor::snmp::agent::make_oid(
-            _functionalOid, ".1.3.6.1.4.1.49769.4.1.%lu.\"%s\"",
-            COLUMN_YADROINVENTORY_FUNCTIONAL, name.c_str());
     }
 
-    void setFields(const fields_map_t& fields) override
+    void setFields(const fields_t& fields) override
     {
         bool isPresent = std::get<FIELD_INVENTORY_PRESENT>(data);
         bool isFunctional = std::get<FIELD_INVENTORY_FUNCTIONAL>(data);
 
-        setField<FIELD_INVENTORY_PRETTY_NAME>(fields, "PrettyName");
-        setField<FIELD_INVENTORY_MANUFACTURER>(fields, "Manufacturer");
-        setField<FIELD_INVENTORY_BUILD_DATE>(fields, "BuildDate");
-        setField<FIELD_INVENTORY_MODEL>(fields, "Model");
-        setField<FIELD_INVENTORY_PART_NUMBER>(fields, "PartNumber");
-        setField<FIELD_INVENTORY_SERIAL_NUMBER>(fields, "SerialNumber");
-        setField<FIELD_INVENTORY_VERSION>(fields, "Version");
-        setField<FIELD_INVENTORY_PRESENT>(fields, "Present");
-        setField<FIELD_INVENTORY_FUNCTIONAL>(fields, "Functional");
+        readFields(fields);
 
         if (isPresent != std::get<FIELD_INVENTORY_PRESENT>(data) ||
             isFunctional != std::get<FIELD_INVENTORY_FUNCTIONAL>(data))
@@ -113,84 +108,132 @@ struct InventoryItem : public phosphor::snmp::data::table::Item<
                         std::get<FIELD_INVENTORY_PRESENT>(data), isFunctional,
                         std::get<FIELD_INVENTORY_FUNCTIONAL>(data)));
 
-            phosphor::snmp::agent::Trap trap(NOTIFY_OID);
-            trap.add_field(_presentOid,
-                           std::get<FIELD_INVENTORY_PRESENT>(data));
-            trap.add_field(_functionalOid,
-                           std::get<FIELD_INVENTORY_FUNCTIONAL>(data));
-            trap.send();
+            send_notify(std::get<FIELD_INVENTORY_PRESENT>(data),
+                        std::get<FIELD_INVENTORY_FUNCTIONAL>(data));
         }
     }
 
-    void get_snmp_reply(netsnmp_agent_request_info* reqinfo,
-                        netsnmp_request_info* request) const override
+    /**
+     * @brief Get OIDs of the present and functional columns of this item.
+     *
+     * @return false if the item name is too long.
+     */
+    bool getStateOids(OID& presentOid, OID& functionalOid) const
     {
-        using namespace phosphor::snmp::agent;
+        presentOid = inventoryTableOid(1, COLUMN_YADROINVENTORY_PRESENT);
+        functionalOid = inventoryTableOid(1, COLUMN_YADROINVENTORY_FUNCTIONAL);
 
-        netsnmp_table_request_info* tinfo = netsnmp_extract_table_info(request);
+        if (!presentOid.appendString(name) ||
+            !functionalOid.appendString(name))
+        {
+            TRACE_ERROR("Inventory item name is too long: '%s'\n",
+                        name.c_str());
+            return false;
+        }
+        return true;
+    }
 
-        switch (tinfo->colnum)
+    /**
+     * @brief Send snmptrap about changed present/functional state.
+     */
+    void send_notify(bool present, bool functional)
+    {
+        if (_notify)
+        {
+            _notify->set(0, present);
+            _notify->set(1, functional);
+            _notify->send();
+        }
+    }
+
+    /**
+     * @brief Add the item into startup summary if it is present
+     *        but not functional.
+     */
+    void addSummary(startup::Summary& summary) const
+    {
+        OID presentOid;
+        OID functionalOid;
+        if (std::get<FIELD_INVENTORY_PRESENT>(data) &&
+            !std::get<FIELD_INVENTORY_FUNCTIONAL>(data) &&
+            getStateOids(presentOid, functionalOid) && summary.addRow())
+        {
+            summary.addField(presentOid, true);
+            summary.addField(functionalOid, false);
+        }
+    }
+
+    bool get_value(int column, netsnmp_variable_list* var) const override
+    {
+        using namespace phosphor::snmp::agent;
+
+        switch (column)
         {
             case COLUMN_YADROINVENTORY_PATH:
-                VariableList::set(request->requestvb, name);
+                VariableList::set(var, name);
                 break;
 
             case COLUMN_YADROINVENTORY_NAME:
-                VariableList::set(request->requestvb,
+                VariableList::set(var,
                                   std::get<FIELD_INVENTORY_PRETTY_NAME>(data));
                 break;
 
             case COLUMN_YADROINVENTORY_MANUFACTURER:
-                VariableList::set(request->requestvb,
+                VariableList::set(var,
                                   std::get<FIELD_INVENTORY_MANUFACTURER>(data));
                 break;
 
             case COLUMN_YADROINVENTORY_BUILD_DATE:
-                VariableList::set(request->requestvb,
+                VariableList::set(var,
                                   std::get<FIELD_INVENTORY_BUILD_DATE>(data));
                 break;
 
             case COLUMN_YADROINVENTORY_MODEL:
-                VariableList::set(request->requestvb,
-                                  std::get<FIELD_INVENTORY_MODEL>(data));
+                VariableList::set(var, std::get<FIELD_INVENTORY_MODEL>(data));
                 break;
 
             case COLUMN_YADROINVENTORY_PART_NUMBER:
-                VariableList::set(request->requestvb,
+                VariableList::set(var,
                                   std::get<FIELD_INVENTORY_PART_NUMBER>(data));
                 break;
 
             case COLUMN_YADROINVENTORY_SERIAL_NUMBER:
                 VariableList::set(
-                    request->requestvb,
-                    std::get<FIELD_INVENTORY_SERIAL_NUMBER>(data));
+                    var, std::get<FIELD_INVENTORY_SERIAL_NUMBER>(data));
                 break;
 
             case COLUMN_YADROINVENTORY_VERSION:
-                VariableList::set(request->requestvb,
-                                  std::get<FIELD_INVENTORY_VERSION>(data));
+                VariableList::set(var, std::get<FIELD_INVENTORY_VERSION>(data));
                 break;
 
             case COLUMN_YADROINVENTORY_PRESENT:
-                VariableList::set(request->requestvb,
-                                  std::get<FIELD_INVENTORY_PRESENT>(data));
+                VariableList::set(var, std::get<FIELD_INVENTORY_PRESENT>(data));
                 break;
 
             case COLUMN_YADROINVENTORY_FUNCTIONAL:
-                VariableList::set(request->requestvb,
+                VariableList::set(var,
                                   std::get<FIELD_INVENTORY_FUNCTIONAL>(data));
                 break;
 
             default:
-                netsnmp_set_request_error(reqinfo, request, SNMP_NOSUCHOBJECT);
-                break;
+                return false;
         }
+        return true;
     }
 
     void onCreate() override
     {
         DEBUGMSGTL(
             ("yadro:inventory", "Inventory item '%s' added.\n", name.c_str()));
+
+        OID presentOid;
+        OID functionalOid;
+        if (getStateOids(presentOid, functionalOid))
+        {
+            _notify.emplace(NOTIFY_OID);
+            _notify->add_field(presentOid, false);
+            _notify->add_field(functionalOid, false);
+        }
     }
 
     void onDestroy() override
@@ -200,19 +243,14 @@ struct InventoryItem : public phosphor::snmp::data::table::Item<
         if (std::get<FIELD_INVENTORY_PRESENT>(data) ||
             std::get<FIELD_INVENTORY_FUNCTIONAL>(data))
         {
-            phosphor::snmp::agent::Trap trap(NOTIFY_OID);
-            trap.add_field(_presentOid, false);
-            trap.add_field(_functionalOid, false);
-            trap.send();
+            send_notify(false, false);
         }
     }
 
-    OID _presentOid;
-    OID _functionalOid;
+    // Prepared in `onCreate()`, empty if the item name is too long.
+    std::optional<phosphor::snmp::agent::TrapTemplate> _notify;
 };
 
-static phosphor::snmp::agent::OID inventoryTableOid = YADRO_OID(4);
-
 static phosphor::snmp::data::Table<InventoryItem>
     inventoryTable("/xyz/openbmc_project/inventory",
                    {
@@ -234,6 +272,13 @@ void init()
                             inventoryTableOid.size(),
                             InventoryItem::COLUMN_YADROINVENTORY_PATH,
                             InventoryItem::COLUMN_YADROINVENTORY_FUNCTIONAL);
+
+    startup::addSummary([](startup::Summary& summary) {
+        summary.addTable(inventoryTableOid, inventoryTable.size());
+        inventoryTable.forEach([&summary](const InventoryItem& item) {
+            item.addSummary(summary);
+        });
+    });
 }
 
 /**
@@ -242,7 +287,8 @@ void init()
 void destroy()
 {
     DEBUGMSGTL(("yadro:shutdown", "Deinitialize yadroInventoryTable\n"));
-    unregister_mib(inventoryTableOid.data(), inventoryTableOid.size());
+    unregister_mib(const_cast<oid*>(inventoryTableOid.data()),
+                   inventoryTableOid.size());
 }
 
 } // namespace inventory
@@ -0,0 +1,290 @@
+/**
+ * @brief YADRO notification log table implementation.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "tracing.hpp"
+#include "journal.hpp"
+#include "yadro/notificationlog.hpp"
+#include "yadro/yadro_oid.hpp"
+
+#include <net-snmp/net-snmp-config.h>
+#include <net-snmp/net-snmp-includes.h>
+#include <net-snmp/agent/net-snmp-agent-includes.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace yadro
+{
+namespace notificationlog
+{
+
+using phosphor::snmp::agent::Journal;
+
+constexpr auto logOid = YADRO_OID(10, 1);
+static const oid zeroDotZero[] = {0, 0};
+
+enum Columns
+{
+    COLUMN_YADRONOTIFICATIONLOG_SEQUENCE = 1,
+    COLUMN_YADRONOTIFICATIONLOG_TIME = 2,
+    COLUMN_YADRONOTIFICATIONLOG_NOTIFICATION = 3,
+    COLUMN_YADRONOTIFICATIONLOG_VARIABLES = 4,
+};
+
+/**
+ * @brief Append numeric OID to the string.
+ */
+static void appendOid(std::string& str, const oid* name, size_t length)
+{
+    for (size_t i = 0; i < length; ++i)
+    {
+        str += '.';
+        str += std::to_string(name[i]);
+    }
+}
+
+/**
+ * @brief Format variables of the record as `OID=VALUE` list.
+ *
+ * snmpTrapOID.0 is skipped, it has own column.
+ */
+static std::string formatVariables(const Journal::Record& record)
+{
+    std::string str;
+    bool first = true;
+    Journal::forEach(record, [&](const Journal::Variable& var) {
+        if (first)
+        {
+            first = false;
+            return;
+        }
+        if (!str.empty())
+        {
+            str += "; ";
+        }
+
+        appendOid(str, var.name.data(), var.name.size());
+        str += '=';
+
+        switch (var.type)
+        {
+            case ASN_INTEGER:
+            case ASN_COUNTER:
+            case ASN_GAUGE:
+            case ASN_TIMETICKS:
+                if (var.length == sizeof(long))
+                {
+                    long value;
+                    memcpy(&value, var.value, sizeof(value));
+                    str += var.type == ASN_INTEGER
+                               ? std::to_string(value)
+                               : std::to_string(static_cast<u_long>(value));
+                }
+                break;
+
+            case ASN_OCTET_STR:
+                str += '"';
+                str.append(reinterpret_cast<const char*>(var.value),
+                           var.length);
+                str += '"';
+                break;
+
+            case ASN_OBJECT_ID:
+            {
+                std::vector<oid> name(var.length / sizeof(oid));
+                memcpy(name.data(), var.value, name.size() * sizeof(oid));
+                appendOid(str, name.data(), name.size());
+            }
+            break;
+
+            default:
+                str += '?';
+                break;
+        }
+    });
+
+    if (record.flags & Journal::TRUNCATED)
+    {
+        str += "; ...";
+    }
+    return str;
+}
+
+/**
+ * @brief Fill the column of the record.
+ */
+static void setColumn(netsnmp_variable_list* var, unsigned colnum,
+                      const Journal::Record& record)
+{
+    switch (colnum)
+    {
+        case COLUMN_YADRONOTIFICATIONLOG_SEQUENCE:
+            snmp_set_var_typed_integer(var, ASN_UNSIGNED, record.sequence);
+            break;
+
+        case COLUMN_YADRONOTIFICATIONLOG_TIME:
+            snmp_set_var_typed_integer(var, ASN_UNSIGNED, record.time / 1000);
+            break;
+
+        case COLUMN_YADRONOTIFICATIONLOG_NOTIFICATION:
+        {
+            // Value of snmpTrapOID.0 is the first variable.
+            bool first = true;
+            bool found = false;
+            Journal::forEach(record, [&](const Journal::Variable& v) {
+                if (first && v.type == ASN_OBJECT_ID)
+                {
+                    snmp_set_var_typed_value(var, ASN_OBJECT_ID, v.value,
+                                             v.length);
+                    found = true;
+                }
+                first = false;
+            });
+            if (!found)
+            {
+                snmp_set_var_typed_value(var, ASN_OBJECT_ID, zeroDotZero,
+                                         sizeof(zeroDotZero));
+            }
+        }
+        break;
+
+        case COLUMN_YADRONOTIFICATIONLOG_VARIABLES:
+        {
+            auto str = formatVariables(record);
+            snmp_set_var_typed_value(var, ASN_OCTET_STR, str.c_str(),
+                                     str.length());
+        }
+        break;
+    }
+}
+
+/**
+ * @brief Handler for snmp requests.
+ *
+ * Rows are indexed by the sequence number, so a collector fetches
+ * the notifications missed since `N` with GETNEXT of `column.N`.
+ */
+static int NotificationLog_snmp_handler(
+    netsnmp_mib_handler* /*handler*/, netsnmp_handler_registration* reginfo,
+    netsnmp_agent_request_info* reqinfo, netsnmp_request_info* requests)
+{
+    const auto& journal = Journal::instance();
+
+    for (auto request = requests; request; request = request->next)
+    {
+        if (request->processed)
+        {
+            continue;
+        }
+
+        netsnmp_table_request_info* tinfo =
+            netsnmp_extract_table_info(request);
+        if (!tinfo)
+        {
+            continue;
+        }
+
+        switch (reqinfo->mode)
+        {
+            case MODE_GET:
+            {
+                auto index = tinfo->indexes;
+                auto record =
+                    index && index->type == ASN_UNSIGNED && index->val.integer
+                        ? journal.find(*index->val.integer)
+                        : nullptr;
+                if (!record)
+                {
+                    netsnmp_set_request_error(reqinfo, request,
+                                              SNMP_NOSUCHINSTANCE);
+                    continue;
+                }
+                setColumn(request->requestvb, tinfo->colnum, *record);
+            }
+            break;
+
+            case MODE_GETNEXT:
+            {
+                uint32_t after =
+                    tinfo->index_oid_len > 0
+                        ? std::min<oid>(tinfo->index_oid[0], UINT32_MAX)
+                        : 0;
+
+                auto record = journal.next(after);
+                if (!record)
+                {
+                    // Start the next column from the first record.
+                    if (++tinfo->colnum > tinfo->reg_info->max_column)
+                    {
+                        continue;
+                    }
+                    record = journal.next(0);
+                }
+
+                // Leave request unanswered at the end of table,
+                // the agent continues with the next subtree.
+                if (record)
+                {
+                    snmp_set_var_typed_integer(tinfo->indexes, ASN_UNSIGNED,
+                                               record->sequence);
+                    netsnmp_table_build_oid(reginfo, request, tinfo);
+                    setColumn(request->requestvb, tinfo->colnum, *record);
+                }
+            }
+            break;
+        }
+    }
+
+    return SNMP_ERR_NOERROR;
+}
+
+/**
+ * @brief Initialize notification log table.
+ */
+void init()
+{
+    DEBUGMSGTL(("yadro:init", "Initialize yadroNotificationLogTable\n"));
+
+    netsnmp_handler_registration* reg = netsnmp_create_handler_registration(
+        "yadroNotificationLogTable", NotificationLog_snmp_handler,
+        logOid.data(), logOid.size(), HANDLER_CAN_RONLY);
+
+    netsnmp_table_registration_info* table_info =
+        SNMP_MALLOC_TYPEDEF(netsnmp_table_registration_info);
+    netsnmp_table_helper_add_indexes(table_info, ASN_UNSIGNED, 0);
+    table_info->min_column = COLUMN_YADRONOTIFICATIONLOG_SEQUENCE;
+    table_info->max_column = COLUMN_YADRONOTIFICATIONLOG_VARIABLES;
+
+    netsnmp_register_table(reg, table_info);
+}
+
+/**
+ * @brief Deinitialize notification log table.
+ */
+void destroy()
+{
+    DEBUGMSGTL(("yadro:shutdown", "Deinitialize yadroNotificationLogTable\n"));
+    unregister_mib(const_cast<oid*>(logOid.data()), logOid.size());
+}
+
+} // namespace notificationlog
+} // namespace yadro
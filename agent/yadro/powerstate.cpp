@@ -18,7 +18,10 @@
  * limitations under the License.
  *
  */
+#include "agentx.hpp"
 #include "data/scalar.hpp"
+#include "stats.hpp"
+#include "yadro/startup.hpp"
 #include "yadro/yadro_oid.hpp"
 #include "tracing.hpp"
 
@@ -36,10 +39,8 @@ namespace power
 {
 namespace state
 {
-using OID = phosphor::snmp::agent::OID;
-
-static const OID state_oid = YADRO_OID(1, 1);
-static const OID notify_oid = YADRO_OID(0, 1);
+constexpr auto state_oid = YADRO_OID(1, 1);
+constexpr auto notify_oid = YADRO_OID(0, 1);
 
 // Values specified in the MIB file.
 constexpr int UNKNOWN = -1;
@@ -92,6 +93,7 @@ struct State : public phosphor::snmp::data::Scalar<std::string>
 };
 
 static State state;
+static auto& stats = phosphor::snmp::agent::Stats::instance().add();
 
 /** @brief Handler for snmp requests */
 static int State_snmp_handler(netsnmp_mib_handler* /*handler*/,
@@ -106,13 +108,20 @@ static int State_snmp_handler(netsnmp_mib_handler* /*handler*/,
     switch (reqinfo->mode)
     {
         case MODE_GET:
+        {
+            auto start = phosphor::snmp::agent::ObjectStats::clock_t::now();
+            size_t variables = 0;
             for (netsnmp_request_info* request = requests; request;
                  request = request->next)
             {
                 phosphor::snmp::agent::VariableList::set(request->requestvb,
                                                          state.toSNMPValue());
+                ++variables;
             }
-            break;
+            stats.served(phosphor::snmp::agent::ObjectStats::GET, start,
+                         variables);
+        }
+        break;
     }
 
     return SNMP_ERR_NOERROR;
@@ -123,10 +132,30 @@ void init()
     DEBUGMSGTL(("yadro:init", "Initialize yadroHostPowerState\n"));
 
     state.update();
+    stats.name = "yadroHostPowerState";
+
+    if (phosphor::snmp::agent::AgentX::enabled)
+    {
+        static phosphor::snmp::agent::Instance instance(
+            state_oid.data(), state_oid.size(),
+            [](netsnmp_variable_list* var) {
+                phosphor::snmp::agent::VariableList::set(var,
+                                                         state.toSNMPValue());
+            },
+            &stats);
+        phosphor::snmp::agent::AgentX::instance().add(&instance);
+    }
+    else
+    {
+        netsnmp_register_read_only_instance(
+            netsnmp_create_handler_registration(
+                "yadroHostPowerState", State_snmp_handler, state_oid.data(),
+                state_oid.size(), HANDLER_CAN_RONLY));
+    }
 
-    netsnmp_register_read_only_instance(netsnmp_create_handler_registration(
-        "yadroHostPowerState", State_snmp_handler, state_oid.data(),
-        state_oid.size(), HANDLER_CAN_RONLY));
+    startup::addSummary([](startup::Summary& summary) {
+        summary.addField(state_oid, state.toSNMPValue());
+    });
 }
 void destroy()
 {
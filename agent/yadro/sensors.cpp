@@ -22,15 +22,42 @@
 #include "tracing.hpp"
 #include "data/table.hpp"
 #include "data/table/item.hpp"
+#include "yadro/sensors.hpp"
+#include "yadro/startup.hpp"
 #include "yadro/yadro_oid.hpp"
+#include "settings.hpp"
 #include "snmptrap.hpp"
 
+#include <array>
+#include <chrono>
 #include <cmath>
+#include <optional>
+#include <stdexcept>
 
 namespace yadro
 {
 namespace sensors
 {
+constexpr auto FLAPPING_OID = YADRO_OID(0, 9);
+
+/**
+ * @brief State changes damping of the sensors table.
+ */
+struct Hysteresis
+{
+    // Min time in the new state before it is reported, 0 - disabled.
+    std::chrono::milliseconds dwell{0};
+    // State changes within the window to report flapping, 0 - disabled.
+    size_t flaps = 0;
+    // Flaps counting window and quiet time to leave flapping.
+    std::chrono::seconds window{60};
+};
+
+/**
+ * @brief Get hysteresis of the table by its arc in YADRO MIB.
+ */
+static const Hysteresis& getHysteresis(oid tableArc);
+
 /**
  * @brief Sensor implementation.
  */
@@ -77,6 +104,14 @@ struct Sensor
         FIELD_SENSOR_CRITHI_ALARM,
     };
 
+    // DBus properties in order of fields
+    static constexpr schema_t schema = phosphor::snmp::data::table::makeSchema(
+        "Value",                             // FIELD_SENSOR_VALUE
+        "WarningLow", "WarningAlarmLow",     // FIELD_SENSOR_WARNLOW*
+        "WarningHigh", "WarningAlarmHigh",   // FIELD_SENSOR_WARNHI*
+        "CriticalLow", "CriticalAlarmLow",   // FIELD_SENSOR_CRITLOW*
+        "CriticalHigh", "CriticalAlarmHigh"); // FIELD_SENSOR_CRITHI*
+
     // Sensor types (first letter in sensors folder name)
     enum Types
     {
@@ -107,23 +142,23 @@ struct Sensor
             switch (folder[n + 1])
             {
                 case ST_TEMPERATURE:
-                    _notifyOid.assign(YADRO_OID(0, 2));
+                    _tableArc = 2;
                     break;
 
                 case ST_VOLTAGE:
-                    _notifyOid.assign(YADRO_OID(0, 3));
+                    _tableArc = 3;
                     break;
 
                 case ST_TACHOMETER:
-                    _notifyOid.assign(YADRO_OID(0, 4));
+                    _tableArc = 4;
                     break;
 
                 case ST_CURRENT:
-                    _notifyOid.assign(YADRO_OID(0, 5));
+                    _tableArc = 5;
                     break;
 
                 case ST_POWER:
-                    _notifyOid.assign(YADRO_OID(0, 6));
+                    _tableArc = 6;
                     break;
             }
 
@@ -136,47 +171,114 @@ struct Sensor
                     break;
             }
         }
-
-        if (!_notifyOid.empty())
-        {
-            phosphor::snmp::agent::make_oid(
-                _stateOid, ".1.3.6.1.4.1.49769.1.%lu.1.7.\"%s\"",
-                _notifyOid.back(), name.c_str());
-        }
+        _scale = std::pow(10., _power);
     }
 
     /**
      * @brief Update fields with new values recieved from DBus.
      */
-    void setFields(const fields_map_t& fields) override
+    void setFields(const fields_t& fields) override
     {
         auto prevValue = getValue<FIELD_SENSOR_VALUE>();
-        auto prevState = getState();
-
-        setField<FIELD_SENSOR_VALUE>(fields, "Value");
-        setField<FIELD_SENSOR_WARNLOW>(fields, "WarningLow");
-        setField<FIELD_SENSOR_WARNLOW_ALARM>(fields, "WarningAlarmLow");
-        setField<FIELD_SENSOR_WARNHI>(fields, "WarningHigh");
-        setField<FIELD_SENSOR_WARNHI_ALARM>(fields, "WarningAlarmHigh");
-        setField<FIELD_SENSOR_CRITLOW>(fields, "CriticalLow");
-        setField<FIELD_SENSOR_CRITLOW_ALARM>(fields, "CriticalAlarmLow");
-        setField<FIELD_SENSOR_CRITHI>(fields, "CriticalHigh");
-        setField<FIELD_SENSOR_CRITHI_ALARM>(fields, "CriticalAlarmHigh");
+        auto prevState = _evaluated;
 
-        auto lastState = getState();
+        readFields(fields);
+        updateCache();
 
         if (prevValue != getValue<FIELD_SENSOR_VALUE>() ||
-            prevState != lastState)
+            prevState != _evaluated)
         {
             DEBUGMSGTL(("yadro:sensors",
                         "Sensor '%s' changed: %d -> %d, state: %d -> %d\n",
                         name.c_str(), prevValue, getValue<FIELD_SENSOR_VALUE>(),
-                        prevState, lastState));
+                        prevState, _evaluated));
         }
 
-        if (prevState != lastState)
+        if (prevState != _evaluated)
         {
-            send_notify(lastState);
+            onStateChanged();
+        }
+    }
+
+    /**
+     * @brief Report the evaluated state according to the table hysteresis.
+     */
+    void onStateChanged()
+    {
+        if (!phosphor::snmp::data::Population::initialized)
+        {
+            // Initial states are reported by the startup summary.
+            reportState();
+            return;
+        }
+
+        const auto& hysteresis = getHysteresis(_tableArc);
+
+        if (hysteresis.flaps > 0)
+        {
+            auto now = std::chrono::steady_clock::now();
+            if (now - _flapsSince > hysteresis.window)
+            {
+                _flapsSince = now;
+                _flaps = 0;
+            }
+            if (!_flapping && ++_flaps >= hysteresis.flaps)
+            {
+                _flapping = true;
+                send_flapping();
+            }
+            if (_flapping)
+            {
+                // Leave flapping after the quiet window.
+                schedule(hysteresis.window);
+                return;
+            }
+        }
+
+        if (_evaluated == _state)
+        {
+            // Returned back before the dwell time is over.
+            cancel();
+        }
+        else if (hysteresis.dwell.count() > 0)
+        {
+            schedule(hysteresis.dwell);
+        }
+        else
+        {
+            reportState();
+        }
+    }
+
+    /**
+     * @brief Dwell time is over or the sensor stopped flapping.
+     */
+    void onTimer() override
+    {
+        if (_flapping)
+        {
+            DEBUGMSGTL(("yadro:sensors", "Sensor '%s' stopped flapping\n",
+                        name.c_str()));
+            _flapping = false;
+            _flaps = 0;
+            // The settled state is reported even if it is the same.
+            _state = _evaluated;
+            send_notify(_state);
+            return;
+        }
+
+        reportState();
+    }
+
+    /**
+     * @brief Make the evaluated state visible and send a trap.
+     */
+    void reportState()
+    {
+        if (_state != _evaluated)
+        {
+            _state = _evaluated;
+            send_notify(_state);
         }
     }
 
@@ -187,6 +289,13 @@ struct Sensor
     {
         DEBUGMSGTL(("yadro:sensors", "Sensor '%s' added, state=%d\n",
                     name.c_str(), getState()));
+
+        phosphor::snmp::agent::OID stateOid;
+        if (getStateOid(stateOid))
+        {
+            _notify.emplace(YADRO_OID(0, _tableArc));
+            _notify->add_field(stateOid, E_NORMAL);
+        }
         send_notify(E_NORMAL);
     }
 
@@ -200,6 +309,18 @@ struct Sensor
         send_notify(E_DISABLED);
     }
 
+    /**
+     * @brief Get OID of the state column of this sensor.
+     *
+     * @return false if the sensor is unsupported.
+     */
+    bool getStateOid(phosphor::snmp::agent::OID& stateOid) const
+    {
+        // Notification and table have the same arc in their subtrees.
+        stateOid = YADRO_OID(1, _tableArc, 1, COLUMN_YADROSENSOR_STATE);
+        return _tableArc != 0 && stateOid.appendString(name);
+    }
+
     /**
      * @brief Send snmptrap about changed state.
      *
@@ -207,11 +328,10 @@ struct Sensor
      */
     void send_notify(state_t state)
     {
-        if (!_notifyOid.empty() && !_stateOid.empty())
+        if (_notify)
         {
-            phosphor::snmp::agent::Trap trap(_notifyOid);
-            trap.add_field(_stateOid.data(), _stateOid.size(), state);
-            trap.send();
+            _notify->set(0, state);
+            _notify->send();
         }
         else
         {
@@ -221,9 +341,35 @@ struct Sensor
     }
 
     /**
-     * @brief Get current state.
+     * @brief Send snmptrap about flapping state.
+     */
+    void send_flapping() const
+    {
+        TRACE_WARNING("Sensor '%s' is flapping, state changes are "
+                      "suppressed\n",
+                      name.c_str());
+
+        phosphor::snmp::agent::OID stateOid;
+        if (getStateOid(stateOid))
+        {
+            phosphor::snmp::agent::Trap trap(FLAPPING_OID);
+            trap.add_field(stateOid, _evaluated);
+            trap.send();
+        }
+    }
+
+    /**
+     * @brief Get reported state.
      */
     state_t getState() const
+    {
+        return _state;
+    }
+
+    /**
+     * @brief Evaluate state by alarm fields.
+     */
+    state_t evalState() const
     {
         if (std::get<FIELD_SENSOR_CRITHI_ALARM>(data))
         {
@@ -246,73 +392,120 @@ struct Sensor
     }
 
     /**
-     * @brief snmp request handler.
+     * @brief Fill the variable with the column value.
      */
-    void get_snmp_reply(netsnmp_agent_request_info* reqinfo,
-                        netsnmp_request_info* request) const override
+    bool get_value(int column, netsnmp_variable_list* var) const override
     {
         using namespace phosphor::snmp::agent;
 
-        netsnmp_table_request_info* tinfo = netsnmp_extract_table_info(request);
-
-        switch (tinfo->colnum)
+        switch (column)
         {
             case COLUMN_YADROSENSOR_NAME:
-                VariableList::set(request->requestvb, name);
+                VariableList::set(var, name);
                 break;
 
             case COLUMN_YADROSENSOR_VALUE:
-                VariableList::set(request->requestvb,
-                                  getValue<FIELD_SENSOR_VALUE>());
+                VariableList::set(var, getValue<FIELD_SENSOR_VALUE>());
                 break;
 
             case COLUMN_YADROSENSOR_WARNLOW:
-                VariableList::set(request->requestvb,
-                                  getValue<FIELD_SENSOR_WARNLOW>());
+                VariableList::set(var, getValue<FIELD_SENSOR_WARNLOW>());
                 break;
 
             case COLUMN_YADROSENSOR_WARNHIGH:
-                VariableList::set(request->requestvb,
-                                  getValue<FIELD_SENSOR_WARNHI>());
+                VariableList::set(var, getValue<FIELD_SENSOR_WARNHI>());
                 break;
 
             case COLUMN_YADROSENSOR_CRITLOW:
-                VariableList::set(request->requestvb,
-                                  getValue<FIELD_SENSOR_CRITLOW>());
+                VariableList::set(var, getValue<FIELD_SENSOR_CRITLOW>());
                 break;
 
             case COLUMN_YADROSENSOR_CRITHIGH:
-                VariableList::set(request->requestvb,
-                                  getValue<FIELD_SENSOR_CRITHI>());
+                VariableList::set(var, getValue<FIELD_SENSOR_CRITHI>());
                 break;
 
             case COLUMN_YADROSENSOR_STATE:
-                VariableList::set(request->requestvb, getState());
+                VariableList::set(var, getState());
                 break;
 
             default:
-                netsnmp_set_request_error(reqinfo, request, SNMP_NOSUCHOBJECT);
-                break;
+                return false;
         }
+        return true;
     }
 
     /**
-     * @brief Scale and round sensors value.
+     * @brief Get scaled and rounded sensors value.
      */
     template <size_t Idx> int getValue() const
     {
-        return static_cast<int>(
-            std::round(std::get<Idx>(data) * powf(10.f, _power)));
+        return _scaled[scaledIndex(Idx)];
+    }
+
+    /**
+     * @brief Index of the numeric field in the scaled values cache.
+     */
+    static constexpr size_t scaledIndex(size_t field)
+    {
+        switch (field)
+        {
+            case FIELD_SENSOR_VALUE:
+                return 0;
+            case FIELD_SENSOR_WARNLOW:
+                return 1;
+            case FIELD_SENSOR_WARNHI:
+                return 2;
+            case FIELD_SENSOR_CRITLOW:
+                return 3;
+            case FIELD_SENSOR_CRITHI:
+                return 4;
+        }
+        throw std::logic_error("Field is not numeric");
+    }
+
+    /**
+     * @brief Scale and round sensors value.
+     */
+    template <size_t Idx> void scaleValue()
+    {
+        constexpr auto index = scaledIndex(Idx);
+        _scaled[index] =
+            static_cast<int>(std::round(std::get<Idx>(data) * _scale));
     }
 
-    std::vector<oid> _notifyOid;
-    std::vector<oid> _stateOid;
+    /**
+     * @brief Prepare values for snmp requests.
+     *
+     * Called once the fields are updated, so serving a request
+     * doesn't involve any calculations.
+     */
+    void updateCache()
+    {
+        scaleValue<FIELD_SENSOR_VALUE>();
+        scaleValue<FIELD_SENSOR_WARNLOW>();
+        scaleValue<FIELD_SENSOR_WARNHI>();
+        scaleValue<FIELD_SENSOR_CRITLOW>();
+        scaleValue<FIELD_SENSOR_CRITHI>();
+        _evaluated = evalState();
+    }
+
+    oid _tableArc = 0;
     int _power = 3;
+    double _scale = 1.;
+    std::array<int, 5> _scaled{};
+    // State reported via SNMP, follows evaluated one with hysteresis.
+    state_t _state = E_NORMAL;
+    state_t _evaluated = E_NORMAL;
+    bool _flapping = false;
+    size_t _flaps = 0;
+    std::chrono::steady_clock::time_point _flapsSince;
+    // Prepared in `onCreate()`, empty for unsupported sensors.
+    std::optional<phosphor::snmp::agent::TrapTemplate> _notify;
 };
 
 struct SensorsTable : public phosphor::snmp::data::Table<Sensor>
 {
-    using OID = std::vector<oid>;
+    using OID = decltype(YADRO_OID(1, 0));
 
     SensorsTable(const std::string& folder, const std::string& tableName,
                  const OID& tableOID) :
@@ -324,13 +517,15 @@ struct SensorsTable : public phosphor::snmp::data::Table<Sensor>
                 "xyz.openbmc_project.Sensor.Threshold.Critical",
                 "xyz.openbmc_project.Sensor.Threshold.Fatal",
             }),
-        tableName(tableName), tableOID(tableOID)
+        folder(folder), tableName(tableName), tableOID(tableOID)
 
     {
     }
 
+    std::string folder;
     std::string tableName;
     OID tableOID;
+    Hysteresis hysteresis;
 };
 
 static std::array<SensorsTable, 5> sensors = {
@@ -341,6 +536,69 @@ static std::array<SensorsTable, 5> sensors = {
     SensorsTable{"power", "yadroPowerSensorsTable", YADRO_OID(1, 6)},
 };
 
+static const Hysteresis& getHysteresis(oid tableArc)
+{
+    static const Hysteresis none;
+
+    for (const auto& s : sensors)
+    {
+        if (s.tableOID.back() == tableArc)
+        {
+            return s.hysteresis;
+        }
+    }
+    return none;
+}
+
+/**
+ * @brief Register sensors directives.
+ */
+void register_settings()
+{
+    phosphor::snmp::agent::settings::add(
+        "sensorHysteresis",
+        [](char* line) {
+            namespace settings = phosphor::snmp::agent::settings;
+
+            char folder[32];
+            line = copy_nword(line, folder, sizeof(folder));
+
+            Hysteresis hysteresis;
+            long long dwell = 0;
+            long long window = hysteresis.window.count();
+            if (!line || !settings::parse(line, dwell) || dwell < 0)
+            {
+                config_perror("dwell time in milliseconds expected");
+                return;
+            }
+            // The window is optional, the default one is used without it.
+            if (settings::parse(line, hysteresis.flaps) &&
+                (line = skip_white(line)) &&
+                (!settings::parse(line, window) || window <= 0))
+            {
+                config_perror("flaps window in seconds expected");
+                return;
+            }
+            hysteresis.dwell = std::chrono::milliseconds{dwell};
+            hysteresis.window = std::chrono::seconds{window};
+
+            bool found = false;
+            for (auto& s : sensors)
+            {
+                if (0 == strcmp(folder, "all") || s.folder == folder)
+                {
+                    s.hysteresis = hysteresis;
+                    found = true;
+                }
+            }
+            if (!found)
+            {
+                config_perror("unknown sensors folder");
+            }
+        },
+        "FOLDER|all DWELL_MS [FLAPS [WINDOW_SEC]]");
+}
+
 /**
  * @brief Update all sensors.
  */
@@ -366,6 +624,21 @@ void init()
                    Sensor::COLUMN_YADROSENSOR_STATE);
         s.update();
     }
+
+    startup::addSummary([](startup::Summary& summary) {
+        for (const auto& s : sensors)
+        {
+            summary.addTable(s.tableOID, s.size());
+            s.forEach([&summary](const Sensor& sensor) {
+                phosphor::snmp::agent::OID stateOid;
+                if (sensor.getState() != Sensor::E_NORMAL &&
+                    sensor.getStateOid(stateOid) && summary.addRow())
+                {
+                    summary.addField(stateOid, sensor.getState());
+                }
+            });
+        }
+    });
 }
 
 /**
@@ -377,7 +650,7 @@ void destroy()
 
     for (auto& s : sensors)
     {
-        unregister_mib(s.tableOID.data(), s.tableOID.size());
+        unregister_mib(const_cast<oid*>(s.tableOID.data()), s.tableOID.size());
     }
 }
 
@@ -25,6 +25,7 @@ namespace yadro
 namespace sensors
 {
 
+void register_settings();
 void init();
 void update();
 void destroy();
@@ -23,6 +23,7 @@
 #include "data/table.hpp"
 #include "data/table/item.hpp"
 #include "data/enums.hpp"
+#include "yadro/startup.hpp"
 #include "yadro/yadro_oid.hpp"
 #include "snmpvars.hpp"
 
@@ -87,39 +88,38 @@ struct Software : public phosphor::snmp::data::table::Item<std::string, uint8_t,
     {
     }
 
+    // DBus properties in order of fields
+    static constexpr schema_t schema = phosphor::snmp::data::table::makeSchema(
+        "Version", "Purpose", "Activation", "Priority");
+
     /**
-     * @brief Set field value with DBus enum converter.
-     *
-     * @tparam Idx - Index of field
-     * @param fields - DBus fields map
-     * @param field - Name of field in DBus
-     * @param enumcvt - Enum converter
+     * @brief Convert DBus enums to fields values.
      */
-    template <size_t Idx>
-    void setFieldEnum(const fields_map_t& fields, const char* field,
-                      const phosphor::snmp::data::DBusEnum<uint8_t>& enumcvt)
+    bool setFieldString(size_t index, std::string_view value) override
     {
-        if (fields.find(field) != fields.end() &&
-            std::holds_alternative<std::string>(fields.at(field)))
+        switch (index)
         {
-            std::get<Idx>(data) =
-                enumcvt.get(std::get<std::string>(fields.at(field)));
+            case FIELD_SOFTWARE_PURPOSE:
+                std::get<FIELD_SOFTWARE_PURPOSE>(data) = purpose.get(value);
+                return true;
+
+            case FIELD_SOFTWARE_ACTIVATION:
+                std::get<FIELD_SOFTWARE_ACTIVATION>(data) =
+                    activation.get(value);
+                return true;
         }
+        return false;
     }
 
     /**
      * @brief Update fields with new values recieved from DBus.
      */
-    void setFields(const fields_map_t& fields) override
+    void setFields(const fields_t& fields) override
     {
         uint8_t prevActivation = std::get<FIELD_SOFTWARE_ACTIVATION>(data),
                 prevPriority = std::get<FIELD_SOFTWARE_PRIORITY>(data);
 
-        setField<FIELD_SOFTWARE_VERSION>(fields, "Version");
-        setFieldEnum<FIELD_SOFTWARE_PURPOSE>(fields, "Purpose", purpose);
-        setFieldEnum<FIELD_SOFTWARE_ACTIVATION>(fields, "Activation",
-                                                activation);
-        setField<FIELD_SOFTWARE_PRIORITY>(fields, "Priority");
+        readFields(fields);
 
         if (prevActivation != std::get<FIELD_SOFTWARE_ACTIVATION>(data) ||
             prevPriority != std::get<FIELD_SOFTWARE_PRIORITY>(data))
@@ -145,49 +145,43 @@ struct Software : public phosphor::snmp::data::table::Item<std::string, uint8_t,
     };
 
     /**
-     * @brief snmp request handler.
+     * @brief Fill the variable with the column value.
      */
-    void get_snmp_reply(netsnmp_agent_request_info* reqinfo,
-                        netsnmp_request_info* request) const override
+    bool get_value(int column, netsnmp_variable_list* var) const override
     {
         using namespace phosphor::snmp::agent;
 
-        netsnmp_table_request_info* tinfo = netsnmp_extract_table_info(request);
-
-        switch (tinfo->colnum)
+        switch (column)
         {
             case COLUMN_YADROSOFTWARE_HASH:
-                VariableList::set(request->requestvb, name);
+                VariableList::set(var, name);
                 break;
 
             case COLUMN_YADROSOFTWARE_VERSION:
-                VariableList::set(request->requestvb,
-                                  std::get<FIELD_SOFTWARE_VERSION>(data));
+                VariableList::set(var, std::get<FIELD_SOFTWARE_VERSION>(data));
                 break;
 
             case COLUMN_YADROSOFTWARE_PURPOSE:
-                VariableList::set(request->requestvb,
-                                  std::get<FIELD_SOFTWARE_PURPOSE>(data));
+                VariableList::set(var, std::get<FIELD_SOFTWARE_PURPOSE>(data));
                 break;
 
             case COLUMN_YADROSOFTWARE_ACTIVATION:
-                VariableList::set(request->requestvb,
+                VariableList::set(var,
                                   std::get<FIELD_SOFTWARE_ACTIVATION>(data));
                 break;
 
             case COLUMN_YADROSOFTWARE_PRIORITY:
-                VariableList::set(request->requestvb,
-                                  std::get<FIELD_SOFTWARE_PRIORITY>(data));
+                VariableList::set(var, std::get<FIELD_SOFTWARE_PRIORITY>(data));
                 break;
 
             default:
-                netsnmp_set_request_error(reqinfo, request, SNMP_NOSUCHOBJECT);
-                break;
+                return false;
         }
+        return true;
     }
 };
 
-constexpr oid softwareOid[] = YADRO_OID(5);
+constexpr auto softwareOid = YADRO_OID(5);
 constexpr auto SOFTWARE_FOLDER = "/xyz/openbmc_project/software";
 
 static phosphor::snmp::data::Table<Software>
@@ -206,10 +200,14 @@ void init()
     DEBUGMSGTL(("yadro:init", "Initialize yadroSoftwareTable\n"));
 
     softwareTable.update();
-    softwareTable.init_mib("yadroSoftwareTable", softwareOid,
-                           OID_LENGTH(softwareOid),
+    softwareTable.init_mib("yadroSoftwareTable", softwareOid.data(),
+                           softwareOid.size(),
                            Software::COLUMN_YADROSOFTWARE_HASH,
                            Software::COLUMN_YADROSOFTWARE_PRIORITY);
+
+    startup::addSummary([](startup::Summary& summary) {
+        summary.addTable(softwareOid, softwareTable.size());
+    });
 }
 
 /**
@@ -218,7 +216,7 @@ void init()
 void destroy()
 {
     DEBUGMSGTL(("yadro:shutdown", "Deinitialize yadroSoftwareTable\n"));
-    unregister_mib(const_cast<oid*>(softwareOid), OID_LENGTH(softwareOid));
+    unregister_mib(const_cast<oid*>(softwareOid.data()), softwareOid.size());
 }
 
 } // namespace software
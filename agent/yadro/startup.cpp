@@ -0,0 +1,92 @@
+/**
+ * @brief YADRO startup summary notification implementation.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#include "tracing.hpp"
+#include "data/population.hpp"
+#include "yadro/startup.hpp"
+
+#include <vector>
+
+namespace yadro
+{
+namespace startup
+{
+constexpr auto NOTIFY_OID = YADRO_OID(0, 8);
+
+static std::vector<provider_t> providers;
+
+void addSummary(provider_t&& provider)
+{
+    providers.emplace_back(std::move(provider));
+}
+
+/**
+ * @brief Send the summary and enable traps.
+ */
+static void sendSummary()
+{
+    auto& dispatcher = phosphor::snmp::agent::TrapDispatcher::instance();
+    dispatcher.unmute();
+
+    phosphor::snmp::agent::Trap trap(NOTIFY_OID);
+    Summary summary(trap);
+    for (auto& provider : providers)
+    {
+        provider(summary);
+    }
+
+    TRACE_INFO("Startup summary: %zu tables, %zu rows not in normal state, "
+               "%llu traps suppressed\n",
+               summary.tables(), summary.rows(),
+               static_cast<unsigned long long>(dispatcher.suppressed()));
+    if (summary.rows() > Summary::maxRows)
+    {
+        TRACE_WARNING("Startup summary: %zu rows are not listed\n",
+                      summary.rows() - Summary::maxRows);
+    }
+
+    trap.send();
+}
+
+void init()
+{
+    // The hold is taken anyway, so the population time covers all tables.
+    phosphor::snmp::data::Population::hold();
+
+    if (phosphor::snmp::agent::TrapDispatcher::startupMode)
+    {
+        DEBUGMSGTL(("yadro:init", "Suppress traps until tables populated\n"));
+        phosphor::snmp::agent::TrapDispatcher::instance().mute();
+        phosphor::snmp::data::Population::whenInitialized(sendSummary);
+    }
+}
+
+void release()
+{
+    phosphor::snmp::data::Population::release();
+}
+
+void destroy()
+{
+    providers.clear();
+}
+
+} // namespace startup
+} // namespace yadro
@@ -0,0 +1,137 @@
+/**
+ * @brief YADRO startup summary notification.
+ *
+ * This file is part of yadro-snmp project.
+ *
+ * Copyright (c) 2018 YADRO
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+#pragma once
+
+#include "snmptrap.hpp"
+#include "yadro/yadro_oid.hpp"
+
+#include <functional>
+
+namespace yadro
+{
+namespace startup
+{
+
+/**
+ * @brief Content of the startup summary notification.
+ */
+class Summary
+{
+  public:
+    /**
+     * @brief Max number of rows not in normal state in the notification.
+     *
+     * Keeps the notification within a single PDU.
+     */
+    static constexpr size_t maxRows = 32;
+
+    explicit Summary(phosphor::snmp::agent::Trap& trap) : _trap(trap)
+    {
+    }
+
+    /**
+     * @brief Add number of rows of the table.
+     *
+     * @param tableOid - Table OID inside the YADRO subtree
+     * @param rows - Number of rows
+     */
+    template <size_t N>
+    void addTable(const phosphor::snmp::agent::FixedOID<N>& tableOid,
+                  size_t rows)
+    {
+        // yadroStartupRows.<table arcs>
+        phosphor::snmp::agent::OID rowsOid = YADRO_OID(10, 3);
+        for (size_t i = YADRO_OID.size(); i < tableOid.size(); ++i)
+        {
+            rowsOid.append(tableOid[i]);
+        }
+        _trap.add_field(rowsOid, static_cast<int>(rows));
+        ++_tables;
+    }
+
+    /**
+     * @brief Reserve place for fields of the row not in normal state.
+     *
+     * @return false if the limit is reached, the row is only counted.
+     */
+    bool addRow()
+    {
+        return ++_rows <= maxRows;
+    }
+
+    /**
+     * @brief Add field to the notification.
+     */
+    template <size_t N, typename T>
+    void addField(const phosphor::snmp::agent::FixedOID<N>& fieldOid,
+                  T&& value)
+    {
+        _trap.add_field(fieldOid, std::forward<T>(value));
+    }
+
+    /** @brief Number of tables. */
+    size_t tables() const
+    {
+        return _tables;
+    }
+
+    /** @brief Number of rows not in normal state. */
+    size_t rows() const
+    {
+        return _rows;
+    }
+
+  private:
+    phosphor::snmp::agent::Trap& _trap;
+    size_t _tables = 0;
+    size_t _rows = 0;
+};
+
+/**
+ * @brief Module contribution to the summary.
+ */
+using provider_t = std::function<void(Summary&)>;
+
+/**
+ * @brief Register summary provider, called by modules on init.
+ */
+void addSummary(provider_t&& provider);
+
+/**
+ * @brief Enter the startup mode, called before modules initialization.
+ *
+ * Traps are suppressed until the initial population of all tables
+ * is complete, then the summary notification is sent.
+ */
+void init();
+
+/**
+ * @brief All modules are initialized.
+ */
+void release();
+
+/**
+ * @brief Release summary providers.
+ */
+void destroy();
+
+} // namespace startup
+} // namespace yadro
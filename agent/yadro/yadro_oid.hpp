@@ -22,7 +22,17 @@
 
 #pragma once
 
-#define YADRO_OID(args...)                                                     \
-    {                                                                          \
-        1, 3, 6, 1, 4, 1, 49769, ##args                                        \
-    }
+#include "snmp_oid.hpp"
+
+namespace yadro
+{
+
+/**
+ * @brief YADRO enterprise OID.
+ *
+ * Derived OIDs are built as `YADRO_OID(1, 2)` at compile time.
+ */
+constexpr phosphor::snmp::agent::FixedOID<7> YADRO_OID = {1, 3, 6, 1, 4, 1,
+                                                          49769};
+
+} // namespace yadro
@@ -25,6 +25,13 @@
 #include <sdbusplus/bus/match.hpp>
 #include <sdbusplus/exception.hpp>
 
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace sdbusplus
 {
 namespace helper
@@ -33,6 +40,347 @@ namespace helper
 constexpr auto OBJECT_MAPPER_IFACE = "xyz.openbmc_project.ObjectMapper";
 constexpr auto OBJECT_MAPPER_PATH = "/xyz/openbmc_project/object_mapper";
 constexpr auto PROPERTIES_IFACE = "org.freedesktop.DBus.Properties";
+constexpr auto OBJECT_MANAGER_IFACE = "org.freedesktop.DBus.ObjectManager";
+
+/**
+ * @brief Cache of the object mapper answers.
+ *
+ * Entries are invalidated by `InterfacesAdded`/`InterfacesRemoved` signals
+ * for the affected object paths and by `NameOwnerChanged` for the
+ * affected services.
+ */
+class MapperCache
+{
+  public:
+    using Interfaces = std::vector<std::string>;
+    using Services = std::map<std::string, Interfaces>;
+    using Objects = std::map<std::string, Services>;
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Default constructor to avoid nullptrs.
+     *         - Copy and move operations due to `this` is bound
+     *           to signal handlers.
+     *     Allowed:
+     *         - Destructor.
+     */
+    MapperCache() = delete;
+    MapperCache(const MapperCache&) = delete;
+    MapperCache& operator=(const MapperCache&) = delete;
+    MapperCache(MapperCache&&) = delete;
+    MapperCache& operator=(MapperCache&&) = delete;
+    ~MapperCache() = default;
+
+    /**
+     * @brief Object constructor
+     *
+     * @param bus - DBus connection to watch for invalidation signals.
+     */
+    explicit MapperCache(sdbusplus::bus::bus& bus) : _bus(bus)
+    {
+        namespace rules = sdbusplus::bus::match::rules;
+
+        _matches.emplace_back(bus, rules::nameOwnerChanged(),
+                              [this](sdbusplus::message::message& m) {
+                                  onNameOwnerChanged(m);
+                              });
+    }
+
+    /**
+     * @brief Find cached service of the object.
+     *
+     * @return Pointer to the service name or nullptr if not cached.
+     */
+    const std::string* findService(const std::string& path,
+                                   const std::string& iface)
+    {
+        auto it = _services.find(path);
+        if (it != _services.end())
+        {
+            auto si = it->second.find(iface);
+            if (si != it->second.end())
+            {
+                ++_hits;
+                return &si->second;
+            }
+        }
+        ++_misses;
+        return nullptr;
+    }
+
+    /**
+     * @brief Store service of the object.
+     */
+    void addService(const std::string& path, const std::string& iface,
+                    const std::string& service)
+    {
+        watch(path);
+        _services[path][iface] = service;
+    }
+
+    /**
+     * @brief Find cached subtree.
+     *
+     * @return Pointer to the subtree or nullptr if not cached.
+     */
+    const Objects* findSubTree(const std::string& path,
+                               const Interfaces& ifaces, int32_t depth)
+    {
+        auto it = _subtrees.find(subTreeKey(path, ifaces, depth));
+        if (it != _subtrees.end())
+        {
+            ++_hits;
+            return &it->second.objects;
+        }
+        ++_misses;
+        return nullptr;
+    }
+
+    /**
+     * @brief Store subtree.
+     *
+     * Services of all objects in subtree are stored too.
+     */
+    void addSubTree(const std::string& path, const Interfaces& ifaces,
+                    int32_t depth, const Objects& objects)
+    {
+        watch(path == "/" ? path : path + "/");
+        _subtrees[subTreeKey(path, ifaces, depth)] = {path, objects};
+
+        for (const auto& [object, services] : objects)
+        {
+            watch(object);
+            for (const auto& [service, interfaces] : services)
+            {
+                for (const auto& iface : interfaces)
+                {
+                    _services[object][iface] = service;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Drop all cached entries.
+     */
+    void clear()
+    {
+        _services.clear();
+        _subtrees.clear();
+        ++_invalidations;
+    }
+
+    /** @brief Number of lookups answered from the cache. */
+    uint64_t hits() const
+    {
+        return _hits;
+    }
+
+    /** @brief Number of lookups forwarded to the mapper. */
+    uint64_t misses() const
+    {
+        return _misses;
+    }
+
+    /** @brief Number of invalidation events which dropped something. */
+    uint64_t invalidations() const
+    {
+        return _invalidations;
+    }
+
+  private:
+    struct SubTree
+    {
+        std::string path;
+        Objects objects;
+    };
+
+    static std::string subTreeKey(const std::string& path,
+                                  const Interfaces& ifaces, int32_t depth)
+    {
+        auto key = path + '\0' + std::to_string(depth);
+        for (const auto& iface : ifaces)
+        {
+            key += '\0';
+            key += iface;
+        }
+        return key;
+    }
+
+    /**
+     * @brief Subscribe to `InterfacesAdded` and `InterfacesRemoved` signals
+     *        of the cached objects.
+     *
+     * @param arg0 - Object path, or folder with trailing '/' to watch
+     *               all objects inside it.
+     */
+    void watch(const std::string& arg0)
+    {
+        for (const auto& it : _watches)
+        {
+            const auto& watched = it.first;
+            if (watched == arg0 ||
+                (watched.back() == '/' &&
+                 0 == arg0.compare(0, watched.length(), watched)))
+            {
+                return;
+            }
+        }
+
+        namespace rules = sdbusplus::bus::match::rules;
+
+        auto& matches = _watches[arg0];
+        matches.emplace_back(_bus,
+                             rules::interfacesAdded() + rules::argNpath(0, arg0),
+                             [this](sdbusplus::message::message& m) {
+                                 onObjectChanged(m);
+                             });
+        matches.emplace_back(
+            _bus, rules::interfacesRemoved() + rules::argNpath(0, arg0),
+            [this](sdbusplus::message::message& m) { onObjectChanged(m); });
+    }
+
+    /**
+     * @brief `InterfacesAdded` and `InterfacesRemoved` signals handler.
+     */
+    void onObjectChanged(sdbusplus::message::message& m)
+    {
+        sdbusplus::message::object_path path;
+        try
+        {
+            // Only object path is required, skip the rest of message.
+            m.read(path);
+        }
+        catch (const sdbusplus::exception::SdBusError&)
+        {
+            clear();
+            return;
+        }
+
+        bool dropped = _services.erase(path.str) > 0;
+        for (auto it = _subtrees.begin(); it != _subtrees.end();)
+        {
+            const auto& root = it->second.path;
+            if (root == "/" ||
+                (0 == path.str.compare(0, root.length(), root) &&
+                 (path.str.length() == root.length() ||
+                  path.str[root.length()] == '/')))
+            {
+                it = _subtrees.erase(it);
+                dropped = true;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (dropped)
+        {
+            ++_invalidations;
+        }
+    }
+
+    /**
+     * @brief `NameOwnerChanged` signal handler.
+     */
+    void onNameOwnerChanged(sdbusplus::message::message& m)
+    {
+        std::string name, oldOwner, newOwner;
+        try
+        {
+            m.read(name, oldOwner, newOwner);
+        }
+        catch (const sdbusplus::exception::SdBusError&)
+        {
+            clear();
+            return;
+        }
+
+        if (!newOwner.empty() && (name.empty() || name[0] == ':'))
+        {
+            // New client connection, nothing to invalidate.
+            return;
+        }
+
+        if (!newOwner.empty())
+        {
+            // New well-known service may provide objects for
+            // any of cached subtrees.
+            if (!_subtrees.empty())
+            {
+                _subtrees.clear();
+                ++_invalidations;
+            }
+        }
+
+        if (oldOwner.empty())
+        {
+            return;
+        }
+
+        // The service is gone or restarted.
+        bool dropped = false;
+        for (auto it = _services.begin(); it != _services.end();)
+        {
+            auto& ifaces = it->second;
+            for (auto si = ifaces.begin(); si != ifaces.end();)
+            {
+                if (si->second == name)
+                {
+                    si = ifaces.erase(si);
+                    dropped = true;
+                }
+                else
+                {
+                    ++si;
+                }
+            }
+            it = ifaces.empty() ? _services.erase(it) : std::next(it);
+        }
+
+        for (auto it = _subtrees.begin(); it != _subtrees.end();)
+        {
+            bool owned = false;
+            for (const auto& object : it->second.objects)
+            {
+                if (object.second.find(name) != object.second.end())
+                {
+                    owned = true;
+                    break;
+                }
+            }
+            if (owned)
+            {
+                it = _subtrees.erase(it);
+                dropped = true;
+            }
+            else
+            {
+                ++it;
+            }
+        }
+
+        if (dropped)
+        {
+            ++_invalidations;
+        }
+    }
+
+    // object path -> interface -> service
+    std::unordered_map<std::string, std::map<std::string, std::string>>
+        _services;
+    std::unordered_map<std::string, SubTree> _subtrees;
+    sdbusplus::bus::bus& _bus;
+    std::vector<sdbusplus::bus::match::match> _matches;
+    // Signal matches by `arg0path` value, never shrinks as the number of
+    // watched paths is limited by the number of MIB objects.
+    std::map<std::string, std::vector<sdbusplus::bus::match::match>> _watches;
+
+    uint64_t _hits = 0;
+    uint64_t _misses = 0;
+    uint64_t _invalidations = 0;
+};
 
 struct helper
 {
@@ -42,6 +390,13 @@ struct helper
         return bus;
     }
 
+    /** @brief Process-wide cache of the mapper answers. */
+    static MapperCache& getMapperCache()
+    {
+        static MapperCache cache(getBus());
+        return cache;
+    }
+
     /** @brief Invoke a method. */
     template <typename... Args>
     static auto callMethod(const std::string& busName, const std::string& path,
@@ -85,11 +440,20 @@ struct helper
     static Objects getSubTree(const std::string& path, const Interfaces& ifaces,
                               int32_t depth = 0)
     {
-        using namespace std::literals::string_literals;
+        auto& cache = getMapperCache();
+        if (auto cached = cache.findSubTree(path, ifaces, depth))
+        {
+            return *cached;
+        }
 
-        return callMethodAndRead<Objects>(
+        auto objects = callMethodAndRead<Objects>(
             OBJECT_MAPPER_IFACE, OBJECT_MAPPER_PATH, OBJECT_MAPPER_IFACE,
             "GetSubTree", path, depth, ifaces);
+        if (!objects.empty())
+        {
+            cache.addSubTree(path, ifaces, depth, objects);
+        }
+        return objects;
     }
 
     /** @brief Get subtree paths from mapper. */
@@ -102,9 +466,24 @@ struct helper
             "GetSubTreePaths", path, depth, ifaces);
     }
 
+    /** @brief Get ancestors of object implementing interfaces. */
+    static Objects getAncestors(const std::string& path,
+                                const Interfaces& ifaces)
+    {
+        return callMethodAndRead<Objects>(
+            OBJECT_MAPPER_IFACE, OBJECT_MAPPER_PATH, OBJECT_MAPPER_IFACE,
+            "GetAncestors", path, ifaces);
+    }
+
     /** @brief Get service provides specified object */
     static Service getService(const Path& path, const Interface& iface)
     {
+        auto& cache = getMapperCache();
+        if (auto cached = cache.findService(path, iface))
+        {
+            return *cached;
+        }
+
         Interfaces ifaces = {iface};
         auto services = callMethodAndRead<Services>(
             OBJECT_MAPPER_IFACE, OBJECT_MAPPER_PATH, OBJECT_MAPPER_IFACE,
@@ -112,6 +491,7 @@ struct helper
 
         if (!services.empty())
         {
+            cache.addService(path, iface, services.begin()->first);
             return std::move(services.begin()->first);
         }
 
@@ -149,6 +529,183 @@ struct helper
     }
 };
 
+/**
+ * @brief Asynchronous method call.
+ *
+ * The request is sent immediately, the callback is invoked from the bus
+ * event loop when the reply (or an error) has been received.
+ * Destroying the object cancels the pending call.
+ */
+class AsyncCall
+{
+  public:
+    using callback_t = std::function<void(sdbusplus::message::message&)>;
+
+    /* Define all of the basic class operations:
+     *     Not allowed:
+     *         - Default constructor to avoid nullptrs.
+     *         - Copy and move operations due to `this` is used as
+     *           userdata of the pending call.
+     *     Allowed:
+     *         - Destructor.
+     */
+    AsyncCall() = delete;
+    AsyncCall(const AsyncCall&) = delete;
+    AsyncCall& operator=(const AsyncCall&) = delete;
+    AsyncCall(AsyncCall&&) = delete;
+    AsyncCall& operator=(AsyncCall&&) = delete;
+    ~AsyncCall() = default;
+
+    /**
+     * @brief Send method call request.
+     *
+     * @param callback - Reply handler
+     * @param busName - DBus service name
+     * @param path - DBus object path
+     * @param interface - DBus interface name
+     * @param method - Method name
+     * @param args - Method arguments
+     *
+     * @throw sdbusplus::exception::SdBusError if request was not sent.
+     */
+    template <typename... Args>
+    AsyncCall(callback_t&& callback, const std::string& busName,
+              const std::string& path, const std::string& interface,
+              const std::string& method, Args&&... args) :
+        _callback(std::move(callback))
+    {
+        auto reqMsg = helper::getBus().new_method_call(
+            busName.c_str(), path.c_str(), interface.c_str(), method.c_str());
+        reqMsg.append(std::forward<Args>(args)...);
+
+        sd_bus_slot* slot = nullptr;
+        int rc = sd_bus_call_async(helper::getBus().get(), &slot,
+                                   reqMsg.get(), AsyncCall::handler, this, 0);
+        if (rc < 0)
+        {
+            throw sdbusplus::exception::SdBusError(-rc, "sd_bus_call_async");
+        }
+        _slot.reset(slot);
+    }
+
+  private:
+    /**
+     * @brief Reply handler registered in sd-bus.
+     */
+    static int handler(sd_bus_message* m, void* userdata, sd_bus_error*)
+    {
+        // The callback is allowed to destroy this object,
+        // so we should not touch any members after it.
+        auto callback = std::move(static_cast<AsyncCall*>(userdata)->_callback);
+        sdbusplus::message::message reply(m);
+        callback(reply);
+        return 0;
+    }
+
+    /**
+     * @brief unique_ptr functor to release a slot reference.
+     */
+    struct SlotDeleter
+    {
+        void operator()(sd_bus_slot* slot) const
+        {
+            sd_bus_slot_unref(slot);
+        }
+    };
+
+    callback_t _callback;
+    std::unique_ptr<sd_bus_slot, SlotDeleter> _slot;
+};
+
+/**
+ * @brief Sequential reader of the message content without allocations.
+ *
+ * Thin wrapper over sd-bus message reading routines, which allows
+ * to walk through containers and skip unnecessary data.
+ * String values point to the message buffer and are valid while
+ * the message exists.
+ */
+class MessageReader
+{
+  public:
+    MessageReader() = delete;
+    MessageReader(const MessageReader&) = delete;
+    MessageReader& operator=(const MessageReader&) = delete;
+    MessageReader(MessageReader&&) = delete;
+    MessageReader& operator=(MessageReader&&) = delete;
+    ~MessageReader() = default;
+
+    explicit MessageReader(sdbusplus::message::message& m) : _m(m.get())
+    {
+    }
+
+    /**
+     * @brief Enter the container.
+     *
+     * @param type - Container type (array, variant, struct or dict entry)
+     * @param contents - Signature of the container contents
+     *
+     * @return false if there are no more containers to enter.
+     */
+    bool enter(char type, const char* contents)
+    {
+        return check(sd_bus_message_enter_container(_m, type, contents),
+                     "sd_bus_message_enter_container") > 0;
+    }
+
+    /** @brief Leave the current container. */
+    void exit()
+    {
+        check(sd_bus_message_exit_container(_m),
+              "sd_bus_message_exit_container");
+    }
+
+    /** @brief Rewind to the beginning of the current container. */
+    void rewind()
+    {
+        check(sd_bus_message_rewind(_m, 0), "sd_bus_message_rewind");
+    }
+
+    /** @brief Skip the values of the specified signature. */
+    void skip(const char* types)
+    {
+        check(sd_bus_message_skip(_m, types), "sd_bus_message_skip");
+    }
+
+    /**
+     * @brief Get signature of the next variant contents.
+     *
+     * @return Signature or nullptr if the next value is not a variant.
+     */
+    const char* peekVariant()
+    {
+        char type = 0;
+        const char* contents = nullptr;
+        check(sd_bus_message_peek_type(_m, &type, &contents),
+              "sd_bus_message_peek_type");
+        return type == SD_BUS_TYPE_VARIANT ? contents : nullptr;
+    }
+
+    /** @brief Read basic value of the specified type. */
+    template <typename T> void read(char type, T& value)
+    {
+        check(sd_bus_message_read_basic(_m, type, &value),
+              "sd_bus_message_read_basic");
+    }
+
+  private:
+    static int check(int rc, const char* what)
+    {
+        if (rc < 0)
+        {
+            throw sdbusplus::exception::SdBusError(-rc, what);
+        }
+        return rc;
+    }
+
+    sd_bus_message* _m;
+};
+
 } // namespace helper
 
 namespace bus
@@ -162,6 +719,12 @@ inline auto propertiesChanged(const std::string& p)
     return type::signal() + path(p) + member("PropertiesChanged") +
            interface(sdbusplus::helper::PROPERTIES_IFACE);
 }
+
+inline auto propertiesChangedNamespace(const std::string& p)
+{
+    return type::signal() + path_namespace(p) + member("PropertiesChanged") +
+           interface(sdbusplus::helper::PROPERTIES_IFACE);
+}
 } // namespace rules
 } // namespace match
 } // namespace bus
@@ -0,0 +1,66 @@
+#!/bin/sh
+#
+# Measure request latency and CPU time of the agent and snmpd.
+#
+# Run once with `builtinAgentX 0` and once with `builtinAgentX 1`
+# in yadro-snmp.conf to compare net-snmp subagent with the built-in
+# AgentX engine.
+#
+# Usage: bench-agentx.sh [COUNT]
+#        SNMP_HOST and SNMP_COMMUNITY environment variables
+#        override the request target.
+
+SNMP_HOST=${SNMP_HOST:-localhost}
+SNMP_COMMUNITY=${SNMP_COMMUNITY:-public}
+SCALAR_OID=.1.3.6.1.4.1.49769.1.1.0
+TABLE_OID=.1.3.6.1.4.1.49769.1.2
+
+COUNT=${1:-100}
+
+now_ms()
+{
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+# User and system CPU time of the process, in clock ticks
+cpu_ticks()
+{
+    pid=$(pidof "$1" | cut -d' ' -f1)
+    if [ -z "${pid}" ]; then
+        echo 0
+        return
+    fi
+    # Fields 14 and 15, the process name in parentheses has no spaces
+    awk '{print $14 + $15}' "/proc/${pid}/stat"
+}
+
+run()
+{
+    title=$1
+    shift
+
+    agent=$(cpu_ticks yadro-snmp-agent)
+    snmpd=$(cpu_ticks snmpd)
+    start=$(now_ms)
+
+    i=0
+    while [ ${i} -lt ${COUNT} ]; do
+        "$@" > /dev/null
+        i=$((i + 1))
+    done
+
+    stop=$(now_ms)
+    agent=$(( $(cpu_ticks yadro-snmp-agent) - agent ))
+    snmpd=$(( $(cpu_ticks snmpd) - snmpd ))
+
+    printf "%-10s %10d %12d %12d\n" "${title}" \
+           "$(( (stop - start) * 1000 / COUNT ))" "${agent}" "${snmpd}"
+}
+
+printf "%-10s %10s %12s %12s\n" "request" "avg, us" "agent ticks" \
+       "snmpd ticks"
+
+run get snmpget -v2c -c "${SNMP_COMMUNITY}" -On "${SNMP_HOST}" \
+                "${SCALAR_OID}"
+run bulkwalk snmpbulkwalk -v2c -c "${SNMP_COMMUNITY}" -On "${SNMP_HOST}" \
+                          "${TABLE_OID}"
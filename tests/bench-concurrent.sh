@@ -0,0 +1,58 @@
+#!/bin/sh
+#
+# Measure throughput of concurrent walks of the YADRO subtree.
+#
+# Run once with a single agent and once with the agent split into
+# processes by modules (`-m` option) to compare, e.g.:
+#     yadro-snmp-agent -m sensors &
+#     yadro-snmp-agent -m power,software,inventory,notifications,stats &
+#
+# Usage: bench-concurrent.sh [CLIENTS [SECONDS]]
+#        SNMP_HOST and SNMP_COMMUNITY environment variables
+#        override the walk target.
+
+SNMP_HOST=${SNMP_HOST:-localhost}
+SNMP_COMMUNITY=${SNMP_COMMUNITY:-public}
+SUBTREE_OID=.1.3.6.1.4.1.49769.1
+
+CLIENTS=${1:-4}
+SECONDS_TOTAL=${2:-30}
+
+RESULTS=$(mktemp -d)
+trap 'rm -rf "${RESULTS}"' EXIT
+
+now_s()
+{
+    date +%s
+}
+
+# Walk until the deadline, write number of walks and values
+client()
+{
+    deadline=$(( $(now_s) + SECONDS_TOTAL ))
+    walks=0
+    values=0
+    while [ $(now_s) -lt ${deadline} ]; do
+        count=$(snmpbulkwalk -v2c -c "${SNMP_COMMUNITY}" -On "${SNMP_HOST}" \
+                             "${SUBTREE_OID}" | wc -l)
+        walks=$((walks + 1))
+        values=$((values + count))
+    done
+    echo "${walks} ${values}" > "${RESULTS}/$1"
+}
+
+i=0
+while [ ${i} -lt ${CLIENTS} ]; do
+    client ${i} &
+    i=$((i + 1))
+done
+wait
+
+cat "${RESULTS}"/* | awk -v clients="${CLIENTS}" -v time="${SECONDS_TOTAL}" '
+    { walks += $1; values += $2 }
+    END {
+        printf "%8s %8s %10s %12s\n", "clients", "walks", "walks/s",
+               "values/s"
+        printf "%8d %8d %10.1f %12.1f\n", clients, walks, walks / time,
+               values / time
+    }'
@@ -0,0 +1,67 @@
+#!/bin/sh
+#
+# Measure request latency during a storm of DBus signals.
+#
+# Value changes of the ambient temperature sensor are emitted by several
+# background processes while the scalar is requested. Compare the result
+# with different `requestPriority` and `dbusPriority` settings, the loop
+# lag is written to the debug log with `loop` token on exit.
+#
+# Usage: bench-storm.sh [COUNT [EMITTERS]]
+#        SNMP_HOST and SNMP_COMMUNITY environment variables
+#        override the request target.
+
+SNMP_HOST=${SNMP_HOST:-localhost}
+SNMP_COMMUNITY=${SNMP_COMMUNITY:-public}
+SCALAR_OID=.1.3.6.1.4.1.49769.1.1.0
+SENSOR=/xyz/openbmc_project/sensors/temperature/ambient
+
+COUNT=${1:-200}
+EMITTERS=${2:-4}
+
+RESULTS=$(mktemp)
+trap 'kill ${PIDS} 2> /dev/null; rm -f "${RESULTS}"' EXIT
+
+now_us()
+{
+    echo $(( $(date +%s%N) / 1000 ))
+}
+
+emitter()
+{
+    value=20000
+    while true; do
+        gdbus emit --system --object-path "${SENSOR}"                      \
+                   --signal org.freedesktop.DBus.Properties.PropertiesChanged \
+                   'xyz.openbmc_project.Sensor.Value'                      \
+                   "{'Value':<int64 ${value}>}" '@as []' > /dev/null
+        value=$(( (value + 1) % 100000 ))
+    done
+}
+
+PIDS=
+i=0
+while [ ${i} -lt ${EMITTERS} ]; do
+    emitter &
+    PIDS="${PIDS} $!"
+    i=$((i + 1))
+done
+
+i=0
+while [ ${i} -lt ${COUNT} ]; do
+    start=$(now_us)
+    snmpget -v2c -c "${SNMP_COMMUNITY}" -On "${SNMP_HOST}" "${SCALAR_OID}" \
+        > /dev/null
+    echo $(( $(now_us) - start )) >> "${RESULTS}"
+    i=$((i + 1))
+done
+
+sort -n "${RESULTS}" | awk '
+    { v[NR] = $1; sum += $1 }
+    END {
+        printf "%8s %10s %10s %10s %10s\n", "requests", "avg, us",
+               "p50, us", "p99, us", "max, us"
+        printf "%8d %10d %10d %10d %10d\n", NR, sum / NR,
+               v[int((NR - 1) * 0.5) + 1], v[int((NR - 1) * 0.99) + 1],
+               v[NR]
+    }'
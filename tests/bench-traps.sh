@@ -0,0 +1,87 @@
+#!/bin/sh
+#
+# Measure trap throughput of the agent.
+#
+# A fake temperature sensor is announced and its warning alarm is
+# toggled, every change is expected to produce one trap. The traps are
+# counted in the snmptrapd log, so snmptrapd should be running with
+# a log file and the agent should have limits disabled:
+#
+#   trapLimit 0
+#   trapRowLimit 0
+#
+# Usage: bench-traps.sh TRAPD_LOG [CHANGES]
+
+TRAPD_LOG=${1:?snmptrapd log file expected}
+CHANGES=${2:-1000}
+FOLDER=/xyz/openbmc_project/sensors/temperature
+SENSOR=${FOLDER}/bench_trap
+# yadroTempSensorStateChange
+NOTIFY_OID=.1.3.6.1.4.1.49769.0.2
+
+set_alarm()
+{
+    gdbus emit --system --object-path "${SENSOR}"                          \
+               --signal org.freedesktop.DBus.Properties.PropertiesChanged   \
+               'xyz.openbmc_project.Sensor.Threshold.Warning'               \
+               "{'WarningAlarmHigh':<$1>}" '@as []' > /dev/null
+}
+
+count_traps()
+{
+    grep -c -e "${NOTIFY_OID}" -e "enterprises.49769.0.2" "${TRAPD_LOG}"
+}
+
+now_ms()
+{
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+gdbus emit --system --object-path '/xyz/openbmc_project/sensors'            \
+           --signal org.freedesktop.DBus.ObjectManager.InterfacesAdded      \
+           "objectpath \"${SENSOR}\""                                       \
+           "{                                                               \
+           'xyz.openbmc_project.Sensor.Threshold.Warning': {                \
+                'WarningHigh':<double 78.0>,                                \
+                'WarningAlarmHigh':<false>                                  \
+           },                                                               \
+           'xyz.openbmc_project.Sensor.Value': {                            \
+                'Value':<double 42.0>                                       \
+           }                                                                \
+           }" > /dev/null
+sleep 1
+
+before=$(count_traps)
+start=$(now_ms)
+
+i=0
+while [ ${i} -lt ${CHANGES} ]; do
+    if [ $((i % 2)) -eq 0 ]; then
+        set_alarm true
+    else
+        set_alarm false
+    fi
+    i=$((i + 1))
+done
+sent=$(now_ms)
+
+# Wait for the queued traps up to 10 seconds
+expected=$((before + CHANGES))
+timeout=$((sent + 10000))
+while [ "$(count_traps)" -lt ${expected} ] && [ "$(now_ms)" -lt ${timeout} ]; do
+    sleep 0.1
+done
+stop=$(now_ms)
+received=$(($(count_traps) - before))
+
+gdbus emit --system --object-path '/xyz/openbmc_project/sensors'            \
+           --signal org.freedesktop.DBus.ObjectManager.InterfacesRemoved    \
+           "objectpath \"${SENSOR}\""                                       \
+           "['xyz.openbmc_project.Sensor.Value',                            \
+             'xyz.openbmc_project.Sensor.Threshold.Warning']" > /dev/null
+
+elapsed=$((stop - start))
+[ ${elapsed} -gt 0 ] || elapsed=1
+printf "%8s %8s %10s %10s\n" "changes" "traps" "time, ms" "traps/sec"
+printf "%8d %8d %10d %10d\n" "${CHANGES}" "${received}" "${elapsed}" \
+       "$((received * 1000 / elapsed))"
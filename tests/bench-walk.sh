@@ -0,0 +1,69 @@
+#!/bin/sh
+#
+# Measure snmpwalk time of the temperature sensors table
+# depending on the number of rows.
+#
+# Fake sensors are announced with InterfacesAdded signals and
+# removed after the measurement.
+#
+# Usage: bench-walk.sh [ROWS...]
+#        SNMP_HOST and SNMP_COMMUNITY environment variables
+#        override the snmpwalk target.
+
+SNMP_HOST=${SNMP_HOST:-localhost}
+SNMP_COMMUNITY=${SNMP_COMMUNITY:-public}
+TABLE_OID=.1.3.6.1.4.1.49769.1.2
+FOLDER=/xyz/openbmc_project/sensors/temperature
+
+ROWS=${*:-10 100 1000 10000}
+
+add_sensor()
+{
+    gdbus emit --system --object-path '/xyz/openbmc_project/sensors'        \
+               --signal org.freedesktop.DBus.ObjectManager.InterfacesAdded  \
+               "objectpath \"${FOLDER}/$1\""                                \
+               "{                                                           \
+               'xyz.openbmc_project.Sensor.Value': {                        \
+                    'Value':<double 42.0>                                   \
+               }                                                            \
+               }" > /dev/null
+}
+
+remove_sensor()
+{
+    gdbus emit --system --object-path '/xyz/openbmc_project/sensors'        \
+               --signal org.freedesktop.DBus.ObjectManager.InterfacesRemoved\
+               "objectpath \"${FOLDER}/$1\""                                \
+               "['xyz.openbmc_project.Sensor.Value']" > /dev/null
+}
+
+now_ms()
+{
+    echo $(( $(date +%s%N) / 1000000 ))
+}
+
+printf "%8s %8s %10s\n" "rows" "values" "walk, ms"
+
+for count in ${ROWS}; do
+    i=0
+    while [ ${i} -lt ${count} ]; do
+        add_sensor "bench${i}"
+        i=$((i + 1))
+    done
+    # Let the agent process the signals
+    sleep 1
+
+    start=$(now_ms)
+    values=$(snmpwalk -v2c -c "${SNMP_COMMUNITY}" -On "${SNMP_HOST}" \
+                      "${TABLE_OID}" | wc -l)
+    stop=$(now_ms)
+
+    printf "%8d %8d %10d\n" "${count}" "${values}" "$((stop - start))"
+
+    i=0
+    while [ ${i} -lt ${count} ]; do
+        remove_sensor "bench${i}"
+        i=$((i + 1))
+    done
+    sleep 1
+done